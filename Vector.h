@@ -1,16 +1,48 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
 
 //--------------------------------
-// Vector
+// Inline buffer
 //--------------------------------
+// Storage for up to N elements inside the vector itself, it is used while they fit
+template<typename T, size_t N>
+struct InlineBuffer {
+    T m_data[N];
+
+    T *get() { return m_data; }
+
+    const T *get() const { return m_data; }
+};
+
 template<typename T>
+struct InlineBuffer<T, 0> {
+    T *get() { return nullptr; }
+
+    const T *get() const { return nullptr; }
+};
+
+//--------------------------------
+// Vector
+//--------------------------------
+// N is the number of elements stored without a heap allocation.
+// Heap buffers come from the allocator current at the construction (see allocator.h).
+template<typename T, size_t N = 0>
 class Vector {
 
     size_t m_size;
     size_t m_capacity;
     T *m_data;
+    Allocator *m_allocator;
+    [[no_unique_address]] InlineBuffer<T, N> m_inline;
+
+    template<typename, size_t> friend class Vector;
 
 public:
 
@@ -21,37 +53,48 @@ public:
 
     [[nodiscard]] size_t capacity() const { return m_capacity; }
 
+    T *data() { return m_data; }
+
+    const T *data() const { return m_data; }
+
+    // nullptr for the global heap
+    [[nodiscard]] Allocator *allocator() const { return m_allocator; }
+
     //--------------------------------
     // Constructors and destructor
     //--------------------------------
-    explicit Vector(size_t N = 0) : m_size(0), m_capacity(N), m_data(nullptr) {
-        if (m_capacity > 0) {
-            m_data = new T[m_capacity];
-            if (!m_data) throw "Out of memory";
-        }
+    explicit Vector(size_t count = 0) : m_size(0), m_allocator(current_allocator) {
+        allocate(count);
     }
 
-    explicit Vector(size_t N, T value) : m_size(N), m_capacity(N), m_data(nullptr) {
-        if (m_capacity > 0) {
-            m_data = new T[m_capacity];
-            if (!m_data) throw "Out of memory";
-        }
-        for (size_t i = 0; i < N; ++i) {
+    explicit Vector(size_t count, T value) : m_size(count), m_allocator(current_allocator) {
+        allocate(count);
+        for (size_t i = 0; i < count; ++i) {
             m_data[i] = value;
         }
     }
 
-    // copy and move constructors
+    // copy and move constructors. The move never allocates: the allocator is taken over with the heap buffer,
+    // and inline elements fit the inline buffer.
     Vector(const Vector &);
     Vector(Vector &&) noexcept;
 
-    // copy and move assignment
+    // moves from a vector with another inline capacity, its heap buffer is taken over.
+    // Allocates if the inline elements of X don't fit the inline buffer.
+    template<size_t M>
+    Vector(Vector<T, M> &&);
+
+    // copy and move assignment, the vector keeps its allocator.
+    // A heap buffer is taken over only from a vector with the same allocator, otherwise elements are moved.
     Vector &operator=(const Vector &);
-    Vector &operator=(Vector &&) noexcept;
+    Vector &operator=(Vector &&);
+
+    template<size_t M>
+    Vector &operator=(Vector<T, M> &&);
 
     // destructor
     ~Vector() {
-        clear();
+        release();
     }
 
     //--------------------------------
@@ -143,22 +186,75 @@ public:
     void empty() { m_size = 0; }
 
     void clear() {
-        if (m_data) {
-            delete[] m_data;
-            m_size = 0;
-            m_capacity = 0;
-            m_data = nullptr;
-        }
+        release();
+        m_size = 0;
+        allocate(0);
     }
 
     iterator find(const T &) const;
 
     void erase(const iterator &);
 
+private:
+    [[nodiscard]] bool is_inline() const { return N > 0 && m_data == m_inline.get(); }
+
+    // sets an empty buffer for at least capacity elements, the inline one if they fit
+    void allocate(size_t capacity) {
+        if (capacity <= N) {
+            m_data = m_inline.get();
+            m_capacity = N;
+        } else {
+            m_data = allocate_buffer(capacity);
+            m_capacity = capacity;
+        }
+    }
+
+    void release() {
+        if (m_data && !is_inline()) {
+            free_buffer(m_data, m_capacity);
+        }
+    }
+
+    T *allocate_buffer(size_t capacity) {
+        const size_t bytes = capacity * sizeof(T);
+        T *buffer = (T *) (m_allocator ? m_allocator->allocate(bytes, alignof(T)) : ::operator new(bytes));
+        if (!buffer) throw "Out of memory";
+        std::uninitialized_default_construct_n(buffer, capacity);
+        return buffer;
+    }
+
+    void free_buffer(T *buffer, size_t capacity) {
+        std::destroy_n(buffer, capacity);
+        if (m_allocator) {
+            m_allocator->deallocate(buffer, capacity * sizeof(T), alignof(T));
+        } else {
+            ::operator delete(buffer);
+        }
+    }
+
+    // takes the elements of X, steals its heap buffer or moves the inline elements one by one
+    template<size_t M>
+    void take(Vector<T, M> &X) {
+        if (X.m_data && !X.is_inline() && X.m_allocator == m_allocator) {
+            m_data = X.m_data;
+            m_capacity = X.m_capacity;
+            m_size = X.m_size;
+        } else {
+            allocate(X.m_size);
+            m_size = X.m_size;
+            for (size_t i = 0; i < m_size; ++i) {
+                m_data[i] = std::move(X.m_data[i]);
+            }
+            X.release();
+        }
+        X.m_size = 0;
+        X.allocate(0);
+    }
+
 };
 
-template<typename T>
-void Vector<T>::push_back(const T &X) {
+template<typename T, size_t N>
+void Vector<T, N>::push_back(const T &X) {
     if (m_size + 1 > m_capacity) {
         reserve((m_capacity + 1) * 2);
     }
@@ -166,66 +262,71 @@ void Vector<T>::push_back(const T &X) {
     ++m_size;
 }
 
-template<typename T>
-void Vector<T>::pop_back() {
+template<typename T, size_t N>
+void Vector<T, N>::pop_back() {
     --m_size;
 }
 
-template<typename T>
-Vector<T>::Vector(const Vector<T> &X) {
+template<typename T, size_t N>
+Vector<T, N>::Vector(const Vector<T, N> &X) : m_allocator(current_allocator) {
+    allocate(X.m_size);
     m_size = X.m_size;
-    m_capacity = X.m_capacity;
-    m_data = new T[m_capacity];
     for (size_t i = 0; i < m_size; ++i)
         m_data[i] = X.m_data[i];
 }
 
-template<typename T>
-Vector<T>::Vector(Vector<T> &&X) noexcept {
-    m_size = X.m_size;
-    m_capacity = X.m_capacity;
-    m_data = X.m_data;
-    X.m_data = nullptr;
-    X.m_size = 0;
-    X.m_capacity = 0;
+template<typename T, size_t N>
+Vector<T, N>::Vector(Vector<T, N> &&X) noexcept : m_allocator(X.m_allocator) {
+    take(X);
 }
 
-template<typename T>
-Vector<T> &Vector<T>::operator=(const Vector<T> &X) {
+template<typename T, size_t N>
+template<size_t M>
+Vector<T, N>::Vector(Vector<T, M> &&X) : m_allocator(X.m_allocator) {
+    take(X);
+}
+
+template<typename T, size_t N>
+Vector<T, N> &Vector<T, N>::operator=(const Vector<T, N> &X) {
     if (this != &X) {
-        if (m_data) delete[] m_data;
+        // The current buffer is reused if it is large enough
+        if (m_capacity < X.m_size) {
+            release();
+            allocate(X.m_size);
+        }
         m_size = X.m_size;
-        m_capacity = X.m_capacity; // m_capacity = X.m_size;
-        m_data = new T[m_capacity];
         for (size_t i = 0; i < m_size; ++i)
             m_data[i] = X.m_data[i];
     }
     return *this;
 }
 
-template<typename T>
-Vector<T> &Vector<T>::operator=(Vector<T> &&X) noexcept {
+template<typename T, size_t N>
+Vector<T, N> &Vector<T, N>::operator=(Vector<T, N> &&X) {
     if (this != &X) {
-        if (m_data) delete[] m_data;
-        m_size = X.m_size;
-        m_capacity = X.m_capacity;
-        m_data = X.m_data;
-        X.m_data = nullptr;
-        X.m_size = 0;
-        X.m_capacity = 0;
+        release();
+        take(X);
     }
     return *this;
 }
 
-template<typename T>
-typename Vector<T>::iterator Vector<T>::find(const T &X) const {
+template<typename T, size_t N>
+template<size_t M>
+Vector<T, N> &Vector<T, N>::operator=(Vector<T, M> &&X) {
+    release();
+    take(X);
+    return *this;
+}
+
+template<typename T, size_t N>
+typename Vector<T, N>::iterator Vector<T, N>::find(const T &X) const {
     for (size_t i = 0; i < m_size; ++i)
         if (m_data[i] == X) return iterator(m_data + i);
     return end();
 }
 
-template<typename T>
-void Vector<T>::erase(const typename Vector<T>::iterator &pos) {
+template<typename T, size_t N>
+void Vector<T, N>::erase(const typename Vector<T, N>::iterator &pos) {
     if (pos == end()) return;
     T *cur = pos.current_;
     while (cur != (m_data + m_size - 1)) {
@@ -235,29 +336,25 @@ void Vector<T>::erase(const typename Vector<T>::iterator &pos) {
     --m_size;
 }
 
-template<typename T>
-void Vector<T>::reserve(size_t new_cap) {
+template<typename T, size_t N>
+void Vector<T, N>::reserve(size_t new_cap) {
     if (new_cap <= m_capacity) return;
-    T *tmp = new T[new_cap];
-    if (!tmp) throw "Out of memory";
-    for (size_t i = 0; i < m_capacity; ++i)
+    T *tmp = allocate_buffer(new_cap);
+    for (size_t i = 0; i < m_size; ++i)
         tmp[i] = std::move(m_data[i]);
-    delete[] m_data;
+    release();
     m_data = tmp;
     m_capacity = new_cap;
 }
 
-template<typename T>
-void Vector<T>::resize(size_t new_size, T value) {
+template<typename T, size_t N>
+void Vector<T, N>::resize(size_t new_size, T value) {
     if (new_size < 0) {
         throw std::invalid_argument("Size can't be less than zero");
     }
-    if (new_size > m_capacity) {
-        reserve(new_size);
-        while (m_size < new_size) {
-            push_back(value);
-        }
-    } else {
-        m_size = new_size;
+    reserve(new_size);
+    while (m_size < new_size) {
+        push_back(value);
     }
+    m_size = new_size;
 }
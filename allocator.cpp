@@ -0,0 +1,111 @@
+#include <bit>
+#include <cstdint>
+#include <new>
+#include "allocator.h"
+
+//--------------------------------
+// Arena
+//--------------------------------
+static char *align_up(char *p, size_t alignment) {
+    return (char *) (((uintptr_t) p + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+Arena::~Arena() {
+    while (m_first) {
+        Block *next = m_first->next;
+        ::operator delete(m_first);
+        m_first = next;
+    }
+}
+
+void Arena::use_block(Block *block) {
+    m_current = block;
+    m_top = (char *) (block + 1);
+    m_end = m_top + block->size;
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment) {
+    char *p = align_up(m_top, alignment);
+    if (m_top && p + bytes <= m_end) {
+        m_top = p + bytes;
+        return p;
+    }
+
+    // The next kept block is used if it is large enough, otherwise a new one is inserted before it
+    const size_t needed = bytes + alignment;
+    Block *next = m_current ? m_current->next : m_first;
+    if (!next || next->size < needed) {
+        const size_t size = needed > m_block_size ? needed : m_block_size;
+        Block *block = (Block *) ::operator new(sizeof(Block) + size);
+        block->next = next;
+        block->size = size;
+        (m_current ? m_current->next : m_first) = block;
+        next = block;
+    }
+    use_block(next);
+
+    p = align_up(m_top, alignment);
+    m_top = p + bytes;
+    return p;
+}
+
+void Arena::deallocate(void *p, size_t bytes, size_t) {
+    if ((char *) p + bytes == m_top) {
+        m_top = (char *) p;
+    }
+}
+
+void Arena::reset() {
+    if (m_first) {
+        use_block(m_first);
+    }
+}
+
+//--------------------------------
+// LimbPool
+//--------------------------------
+// Index of the smallest class of at least bytes, class_count if there is none
+static size_t size_class(size_t bytes, size_t min_class_pow, size_t class_count) {
+    const size_t pow = std::bit_width(bytes - 1);
+    if (pow >= min_class_pow + class_count) {
+        return class_count;
+    }
+    return pow > min_class_pow ? pow - min_class_pow : 0;
+}
+
+LimbPool::~LimbPool() {
+    release();
+}
+
+void *LimbPool::allocate(size_t bytes, size_t) {
+    const size_t c = size_class(bytes, min_class_pow, class_count);
+    if (c == class_count) {
+        return ::operator new(bytes);
+    }
+    if (FreeBuffer *buffer = m_free[c]) {
+        m_free[c] = buffer->next;
+        return buffer;
+    }
+    return ::operator new((size_t) 1 << (c + min_class_pow));
+}
+
+void LimbPool::deallocate(void *p, size_t bytes, size_t) {
+    const size_t c = size_class(bytes, min_class_pow, class_count);
+    if (c == class_count) {
+        ::operator delete(p);
+        return;
+    }
+    auto *buffer = (FreeBuffer *) p;
+    buffer->next = m_free[c];
+    m_free[c] = buffer;
+}
+
+void LimbPool::release() {
+    for (auto &list : m_free) {
+        while (list) {
+            FreeBuffer *next = list->next;
+            ::operator delete(list);
+            list = next;
+        }
+    }
+}
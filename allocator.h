@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+
+//--------------------------------
+// Allocator
+//--------------------------------
+// Source of memory for Vector buffers. Alignments up to alignof(std::max_align_t) are supported.
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+
+    virtual void *allocate(size_t bytes, size_t alignment) = 0;
+
+    virtual void deallocate(void *p, size_t bytes, size_t alignment) = 0;
+};
+
+// Allocator of the vectors created by this thread, nullptr means the global heap.
+// A vector keeps the allocator it was created with, so the allocator must outlive it.
+inline thread_local Allocator *current_allocator = nullptr;
+
+// Makes an allocator current for this thread while the scope is alive
+class AllocatorScope {
+    Allocator *m_previous;
+
+public:
+    explicit AllocatorScope(Allocator &allocator) : m_previous(current_allocator) {
+        current_allocator = &allocator;
+    }
+
+    // makes the global heap current, for values that outlive the allocator of the caller
+    explicit AllocatorScope(std::nullptr_t) : m_previous(current_allocator) {
+        current_allocator = nullptr;
+    }
+
+    ~AllocatorScope() {
+        current_allocator = m_previous;
+    }
+
+    AllocatorScope(const AllocatorScope &) = delete;
+
+    AllocatorScope &operator=(const AllocatorScope &) = delete;
+};
+
+//--------------------------------
+// Arena
+//--------------------------------
+// Bump allocator: memory is given back all at once by reset() or the destructor.
+// Only the most recent allocation can be freed separately, so nested temporaries are reused.
+class Arena : public Allocator {
+    struct Block {
+        Block *next;
+        size_t size;
+    };
+
+    Block *m_first = nullptr;
+    Block *m_current = nullptr;
+    char *m_top = nullptr;
+    char *m_end = nullptr;
+    size_t m_block_size;
+
+public:
+    explicit Arena(size_t block_size = 1 << 16) : m_block_size(block_size) {}
+
+    ~Arena() override;
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t alignment) override;
+
+    void deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    // frees everything in O(1), the blocks are kept for the next allocations
+    void reset();
+
+private:
+    void use_block(Block *block);
+};
+
+//--------------------------------
+// LimbPool
+//--------------------------------
+// Keeps freed buffers in lists by power of 2 size classes and gives them out again
+// without going to the global heap. Buffers larger than the biggest class are not cached.
+class LimbPool : public Allocator {
+    static const size_t min_class_pow = 4;
+    static const size_t class_count = 20;
+
+    struct FreeBuffer {
+        FreeBuffer *next;
+    };
+
+    FreeBuffer *m_free[class_count] = {};
+
+public:
+    LimbPool() = default;
+
+    ~LimbPool() override;
+
+    LimbPool(const LimbPool &) = delete;
+
+    LimbPool &operator=(const LimbPool &) = delete;
+
+    void *allocate(size_t bytes, size_t alignment) override;
+
+    void deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    // returns the cached buffers to the global heap
+    void release();
+};
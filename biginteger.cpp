@@ -1,72 +1,165 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include "biginteger.h"
+#include "reciprocal.h"
+#include "limbs.h"
+#include "montgomery.h"
+#include "scratch.h"
+
+// Numbers up to this size (in limbs) are converted to strings by repeated short divisions
+static const size_t radix_conversion_threshold = 30;
+
+// A chunk of digits that is peeled off by a single short division, base = radix^digits fits in a limb
+struct RadixChunk {
+    size_t digits;
+    limb_t base;
+};
+
+static RadixChunk radix_chunk(int radix) {
+    RadixChunk chunk = {0, 1};
+    while (chunk.base <= std::numeric_limits<limb_t>::max() / radix) {
+        chunk.base *= radix;
+        ++chunk.digits;
+    }
+    return chunk;
+}
+
+// Powers are computed on demand and cached for all further conversions in this radix. The cache lives
+// as long as the process, so it is built in the global heap and not in the current allocator.
+const BigInteger &BigInteger::radix_power(int radix, size_t i) {
+    static std::mutex mutex;
+    static std::unique_ptr<BigInteger> powers[37][64];
+
+    std::lock_guard<std::mutex> lock(mutex);
+    AllocatorScope heap(nullptr);
+    for (size_t j = 0; j <= i; ++j) {
+        if (!powers[radix][j]) {
+            powers[radix][j] = std::make_unique<BigInteger>(j == 0 ? BigInteger(radix_chunk(radix).base) : *powers[radix][j - 1]);
+            if (j > 0) {
+                powers[radix][j]->square();
+            }
+        }
+    }
+    return *powers[radix][i];
+}
+
+// Writes the digits of a chunk backwards from digit, but not before out. Returns the last written digit,
+// the digits that didn't fit are left in chunk_value. The radix may be a std::integral_constant,
+// then the divisions are by a constant.
+template<typename Radix>
+static char *write_chunk(char *digit, const char *out, limb_t &chunk_value, size_t digits, Radix radix) {
+    for (size_t i = 0; i < digits && digit > out; ++i) {
+        *--digit = digit_char(chunk_value % radix, radix);
+        chunk_value /= radix;
+    }
+    return digit;
+}
+
+size_t BigInteger::radix_power_digits(int radix, size_t i) {
+    return radix_chunk(radix).digits << i;
+}
+
+static bool is_supported_radix(int radix) {
+    return (2 <= radix && radix <= 36) || radix == 64;
+}
+
+BigInteger::BigInteger(std::string_view s) : m_is_positive(true) {
+    parse(s, 10);
+}
+
+BigInteger BigInteger::from_string(std::string_view s, int radix) {
+    if (!is_supported_radix(radix)) {
+        throw std::invalid_argument("Unsupported radix");
+    }
+    BigInteger result;
+    result.parse(s, radix);
+    return result;
+}
 
-BigInteger::BigInteger(const std::string &s) {
+void BigInteger::parse(std::string_view s, int radix) {
     if (s.empty()) {
         throw std::invalid_argument("string can't be empty");
     }
 
-    m_is_positive = s[0] != '-';
-
-    // We temporary store number as a big integer with base 10^12
-    const size_t temp_number_size = s.size() - (m_is_positive ? 0 : 1);
+    m_is_positive = true;
+    if (s[0] == '-') {
+        m_is_positive = false;
+        s.remove_prefix(1);
+    }
 
-    if (temp_number_size == 0) {
+    if (s.empty()) {
         throw std::invalid_argument("string should have at least 1 digit");
     }
 
-    const int temp_number_base_pow = 9;
-    const uint64_t temp_number_base = pow((uint64_t) 10, temp_number_base_pow);
-    const char *const temp_number_begin = s.c_str() + (m_is_positive ? 0 : 1);
-    Vector<uint64_t> temp_number(
-            div_with_rounding_up(
-                    temp_number_size,
-                    (size_t) temp_number_base_pow
-            )
-    );
-
-    // parsing str to temp_number
-    for (
-            const char *digit_end = temp_number_begin + temp_number_size;
-            digit_end > temp_number_begin;
-            digit_end -= temp_number_base_pow
-            ) {
-        int digit_size = min(temp_number_base_pow, (int) (digit_end - temp_number_begin));
-        uint64_t res = parse_n_char_str_to_unsigned_int(digit_end - digit_size, digit_size);
-        temp_number.push_back(res);
-    }
-
-    // Translate temp_number to base 2 ^ 32 by dividing by 2 ^ 16 (otherwise uint64 can overflow) until it is less than 2 ^ 32
-    uint64_t iteration = 0;
-    const int divider_pow = (int) div_by_pow_of_2(BASE_POW, 1);
-    const uint64_t divider = mult_by_pow_of_2(1, divider_pow);
-    while (temp_number.size() > 1 || temp_number.front() >= divider) {
-
-        uint64_t carry = 0;
-        for (long i = temp_number.size() - 1; i >= 0; --i) {
-            uint64_t cur = temp_number[i] + carry * temp_number_base;
-            temp_number[i] = div_by_pow_of_2(cur, divider_pow);
-            carry = mod_by_pow_of_2(cur, divider_pow);
-        }
-
-        // remove trailing zeros
-        while (temp_number.size() > 1 && temp_number.back() == 0)
-            temp_number.pop_back();
+    if (is_power_of_two_radix(radix)) {
+        parse_power_of_two_radix(s.data(), s.size(), radix);
+    } else {
+        m_digits = std::move(parse_radix(s.data(), s.size(), radix).m_digits);
+    }
+    check_zero_sign();
+}
 
-        if (is_odd(iteration)) {
-            m_digits[m_digits.size() - 1] += mult_by_pow_of_2(carry, BASE_POW / 2);
-        } else {
-            m_digits.push_back((uint32_t) carry);
+void BigInteger::parse_power_of_two_radix(const char *s, size_t n, int radix) {
+    const unsigned bits = std::countr_zero((unsigned) radix);
+    m_digits.resize(div_with_rounding_up<size_t>(n * bits, BASE_POW));
+    limb_t *digits = m_digits.data();
+    zero_limbs(digits, m_digits.size());
+
+    // From the lowest digit, a digit may be split between two limbs
+    size_t position = 0;
+    for (size_t i = n; i-- > 0; position += bits) {
+        const int value = digit_value(s[i], radix);
+        if (value < 0) {
+            throw std::invalid_argument("string contains non-digit char");
+        }
+        const size_t limb = position / BASE_POW;
+        const unsigned shift = position % BASE_POW;
+        digits[limb] |= (limb_t) value << shift;
+        if (shift + bits > BASE_POW) {
+            digits[limb + 1] |= (limb_t) value >> (BASE_POW - shift);
         }
+    }
+    remove_high_order_zeros();
+}
 
-        ++iteration;
+BigInteger BigInteger::parse_radix(const char *s, size_t n, int radix) {
+    const RadixChunk chunk = radix_chunk(radix);
+    // Short strings are parsed by chunks, the first chunk takes the remainder
+    if (n <= radix_conversion_threshold * chunk.digits) {
+        BigInteger result;
+        result.m_digits.reserve(n / chunk.digits + 1);
+        size_t chunk_size = n % chunk.digits == 0 ? chunk.digits : n % chunk.digits;
+        for (const char *begin = s; begin < s + n; begin += chunk_size, chunk_size = chunk.digits) {
+            limb_t chunk_value = 0, chunk_base = 1;
+            for (const char *c = begin; c < begin + chunk_size; ++c) {
+                const int value = digit_value(*c, radix);
+                if (value < 0) {
+                    throw std::invalid_argument("string contains non-digit char");
+                }
+                chunk_value = chunk_value * radix + value;
+                chunk_base *= radix;
+            }
+            result.multiply_by_short_number(chunk_base, chunk_value);
+        }
+        return result;
     }
-    if (is_odd(iteration)) {
-        m_digits[m_digits.size() - 1] += mult_by_pow_of_2(temp_number.front(), BASE_POW / 2);
-    } else {
-        m_digits.push_back(temp_number.front());
+
+    // Split by the smallest cached power of the radix that takes at least half of the digits
+    size_t i = 0;
+    while (2 * (chunk.digits << i) < n) {
+        ++i;
     }
+    const size_t low_size = chunk.digits << i;
 
-    check_zero_sign();
+    BigInteger result = parse_radix(s, n - low_size, radix);
+    result *= radix_power(radix, i);
+    result += parse_radix(s + n - low_size, low_size, radix);
+    return result;
 }
 
 BigInteger::BigInteger(const BigInteger &num) {
@@ -88,72 +181,50 @@ BigInteger &BigInteger::operator=(BigInteger &&num) noexcept {
 }
 
 BigInteger &BigInteger::operator+=(const BigInteger &b) {
-    // Handle different signs
-    if (m_is_positive && !b.m_is_positive) {
-        return this->operator-=(-b);
-    } else if (!m_is_positive && b.m_is_positive) {
-        change_sign();
-        this->operator-=(b);
-        change_sign();
-        check_zero_sign();
-        return *this;
+    if (this == &b) {
+        return multiply_by_short_number(2);
     }
-
-    return add_number_with_same_sign(b);
+    return add_signed(b.m_digits.data(), b.m_digits.size(), b.m_is_positive);
 }
 
 BigInteger &BigInteger::operator-=(const BigInteger &b) {
-    // Handle different signs and check that abs(*this) is not less than abs(b)
-    if (m_is_positive == !b.m_is_positive) {
-        return add_number_with_same_sign(b);
-    } else if ((m_is_positive && *this < b) || (!m_is_positive && *this > b)) {
-
-        // swap *this and b
-        auto temp = b;
-        temp.subtract_lesser_number_with_same_sign(*this);
-        temp.change_sign();
-        temp.check_zero_sign();
-
-        *this = std::move(temp);
+    if (this == &b) {
+        *this = 0;
         return *this;
     }
-
-    return subtract_lesser_number_with_same_sign(b);
+    return add_signed(b.m_digits.data(), b.m_digits.size(), !b.m_is_positive);
 }
 
 BigInteger &BigInteger::operator*=(const BigInteger &b) {
     if (is_zero() || b.is_zero()) {
         *this = 0;
+        return *this;
     }
 
-    BigInteger result;
-    result.m_is_positive = m_is_positive == b.m_is_positive;
-    result.m_digits.reserve(m_digits.size() + b.m_digits.size() + 1);
-    for (size_t i = 1; i < m_digits.size() + b.m_digits.size(); ++i) {
-        result.m_digits.push_back(0);
-    }
-
-    uint64_t digit, carry;
-    for (size_t j = 0; j < b.m_digits.size(); ++j) {
-        if (b.m_digits[j] == 0) {
-            result.m_digits[j + m_digits.size()] = 0;
-        } else {
-            carry = 0;
-            for (size_t k = 0; k < m_digits.size(); ++k) {
-                digit = (uint64_t) m_digits[k] * b.m_digits[j] + (uint64_t) result.m_digits[k + j] + carry;
-                result.m_digits[k + j] = mod_by_pow_of_2(digit, BASE_POW);
-                carry = div_by_pow_of_2(digit, BASE_POW);
-            }
-            result.m_digits[j + m_digits.size()] = (uint32_t) carry;
-        }
-    }
+    // Squaring is much faster, mul() uses it when both operands are the same span
+    const limb_t *b_digits = this == &b || is_abs_equal(b) ? m_digits.data() : b.m_digits.data();
 
-    result.remove_high_order_zeros();
+    // The product goes to the scratch space, so the buffer of the number is reused when it is large enough
+    ScratchFrame frame;
+    const size_t n = m_digits.size() + b.m_digits.size();
+    limb_t *result = frame.alloc(n);
+    mul(result, m_digits.data(), m_digits.size(), b_digits, b.m_digits.size());
 
-    *this = std::move(result);
+    assign_digits(result, n);
+    m_is_positive = m_is_positive == b.m_is_positive;
     return *this;
 }
 
+BigInteger &BigInteger::square() {
+    return *this *= *this;
+}
+
+// The reciprocal costs about as much as a recursive division of 2n limbs by n,
+// so it pays off only when the quotient is several times longer than a huge divisor
+static bool use_reciprocal(size_t an, size_t bn) {
+    return bn >= div_thresholds.barrett && an - bn >= 4 * bn;
+}
+
 BigInteger &BigInteger::operator/=(const BigInteger &a) {
     if (a.is_zero()) {
         throw std::runtime_error("Division by zero.");
@@ -168,69 +239,120 @@ BigInteger &BigInteger::operator/=(const BigInteger &a) {
     if (a.m_digits.size() == 1) {
         divide_by_short_number(a.m_digits.back());
         m_is_positive = m_is_positive == a.m_is_positive;
+        check_zero_sign();
         return *this;
     }
-    size_t cnt = m_digits.size();
-    BigInteger result;
-    result.m_digits.resize(m_digits.size() - a.m_digits.size() + 1);
-    BigInteger copy2 = a;
-    uint64_t d = base / (a.m_digits.back() + 1);
-
-    *this *= d;
-    if (m_digits.size() <= cnt) {
-        m_digits.push_back(0);
-    }
-    copy2 *= d;
-    int carry;
-    uint64_t possible_q, possible_r, digit, product;
-    for (long j = result.m_digits.size() - 1; j >= 0; --j) {
-        const uint64_t divisible =
-                mult_by_pow_of_2(m_digits[j + a.m_digits.size()], BASE_POW) + m_digits[j + a.m_digits.size() - 1];
-        possible_q = divisible / copy2.m_digits[a.m_digits.size() - 1];
-        possible_r = divisible % copy2.m_digits[a.m_digits.size() - 1];
-        do {
-            if (possible_q == base || (possible_q * (copy2.m_digits[a.m_digits.size() - 2]) >
-                                       (mult_by_pow_of_2(possible_r, BASE_POW) +
-                                        m_digits[j + a.m_digits.size() - 2]))) {
-                --possible_q;
-                possible_r += copy2.m_digits[a.m_digits.size() - 1];
-            } else {
-                break;
-            }
-        } while (possible_r < base);
-        carry = 0;
-        for (size_t i = 0; i < a.m_digits.size(); ++i) {
-            product = possible_q * copy2.m_digits[i];
-            digit = m_digits[i + j] - mod_by_pow_of_2(product, BASE_POW) - carry;
-            m_digits[i + j] = digit;
-            carry = (int) (div_by_pow_of_2(product, BASE_POW) - div_by_pow_of_2(digit, BASE_POW));
-        }
-        digit = m_digits[j + a.m_digits.size()] - carry;
-        m_digits[j + a.m_digits.size()] = digit;
-        result.m_digits[j] = possible_q;
-        if (digit < 0) {
-            --result.m_digits[j];
-            carry = 0;
-            for (size_t i = 0; i < a.m_digits.size(); ++i) {
-                digit = m_digits[i + j] + copy2.m_digits[i] + carry;
-                carry = (int) div_by_pow_of_2(digit, BASE_POW);
-                m_digits[i + j] = digit;
-            }
-            m_digits[j + a.m_digits.size()] += carry;
-        }
-    }
-    result.m_is_positive = m_is_positive == a.m_is_positive;
-    result.remove_high_order_zeros();
-    *this = std::move(result);
+    divide(*this, a, this, nullptr);
     return *this;
 }
 
 BigInteger &BigInteger::operator%=(const BigInteger &b) {
-    // TODO: write more efficient code
-    *this -= (*this / b) * b;
+    divide(*this, b, nullptr, this);
     return *this;
 }
 
+std::pair<BigInteger, BigInteger> BigInteger::divmod(const BigInteger &b) const {
+    std::pair<BigInteger, BigInteger> result;
+    div_mod(*this, b, result.first, result.second);
+    return result;
+}
+
+void div_mod(const BigInteger &a, const BigInteger &b, BigInteger &q, BigInteger &r) {
+    BigInteger::divide(a, b, &q, &r);
+}
+
+void BigInteger::divide(const BigInteger &a, const BigInteger &b, BigInteger *q, BigInteger *r) {
+    if (b.is_zero()) {
+        throw std::runtime_error("Division by zero.");
+    }
+    const size_t an = a.m_digits.size(), bn = b.m_digits.size();
+    if (an < bn) {
+        // The remainder is written first, because the quotient may be the same object as a
+        if (r) {
+            *r = a;
+        }
+        if (q) {
+            *q = 0;
+        }
+        return;
+    }
+    if (use_reciprocal(an, bn)) {
+        BigInteger quotient, remainder;
+        Reciprocal(b).div_mod(a, quotient, remainder);
+        if (q) {
+            *q = std::move(quotient);
+        }
+        if (r) {
+            *r = std::move(remainder);
+        }
+        return;
+    }
+    ScratchFrame frame;
+    limb_t *quotient = frame.alloc(an - bn + 1), *remainder = r ? frame.alloc(bn) : nullptr;
+    divrem(quotient, remainder, a.m_digits.data(), an, b.m_digits.data(), bn);
+
+    // a and b are not used after this point, so they can be overwritten
+    const bool a_is_positive = a.m_is_positive, b_is_positive = b.m_is_positive;
+    if (q) {
+        q->assign_digits(quotient, an - bn + 1);
+        q->m_is_positive = a_is_positive == b_is_positive;
+        q->check_zero_sign();
+    }
+    if (r) {
+        r->assign_digits(remainder, bn);
+        r->m_is_positive = a_is_positive;
+        r->check_zero_sign();
+    }
+}
+
+BigInteger pow_mod(const BigInteger &base, const BigInteger &exp, const BigInteger &mod) {
+    if (exp < 0) {
+        throw std::invalid_argument("Exponent must be non-negative.");
+    }
+    BigInteger modulus = mod;
+    modulus.m_is_positive = true;
+    if (is_odd(modulus.m_digits[0])) {
+        return MontgomeryContext(modulus).pow_mod(base, exp);
+    }
+
+    const Reciprocal reciprocal(modulus);
+    BigInteger x = reciprocal.remainder(base);
+    if (x < 0) {
+        x += modulus;
+    }
+
+    // Odd powers x^1, x^3, ..., x^(2^window_size - 1) for the sliding window
+    const size_t window_size = exponent_window_size(exp.m_digits.size() * BASE_POW);
+    Vector<BigInteger> powers(mult_by_pow_of_2(1, window_size - 1), x);
+    if (powers.size() > 1) {
+        const BigInteger x2 = reciprocal.remainder(x * x);
+        for (size_t i = 1; i < powers.size(); ++i) {
+            powers[i] = reciprocal.remainder(powers[i - 1] * x2);
+        }
+    }
+
+    BigInteger result = 1;
+    scan_exponent_windows(exp.m_digits.data(), exp.m_digits.size(), window_size,
+                          [&] { result = reciprocal.remainder(result.square()); },
+                          [&](size_t i) { result = reciprocal.remainder(result *= powers[i]); });
+    return result;
+}
+
+BigInteger pow(const BigInteger &base, uint64_t exp) {
+    if (exp == 0) {
+        return 1;
+    }
+    // Left-to-right binary method: the result is squared, the multiplications are by the short base
+    BigInteger result = base;
+    for (int bit = 62 - std::countl_zero(exp); bit >= 0; --bit) {
+        result.square();
+        if (is_odd(div_by_pow_of_2(exp, bit))) {
+            result *= base;
+        }
+    }
+    return result;
+}
+
 BigInteger operator+(const BigInteger &a) {
     BigInteger res = a;
     res.m_is_positive = true;
@@ -245,14 +367,24 @@ BigInteger operator-(const BigInteger &a) {
 }
 
 BigInteger &BigInteger::operator++() {
-    // TODO: write more efficient code
-    *this += 1;
+    if (m_is_positive) {
+        increment_abs();
+    } else {
+        decrement_abs();
+        check_zero_sign();
+    }
     return *this;
 }
 
 BigInteger &BigInteger::operator--() {
-    // TODO: write more efficient code
-    *this -= 1;
+    if (is_zero()) {
+        m_digits[0] = 1;
+        m_is_positive = false;
+    } else if (m_is_positive) {
+        decrement_abs();
+    } else {
+        increment_abs();
+    }
     return *this;
 }
 
@@ -267,193 +399,311 @@ bool operator<(const BigInteger &a, const BigInteger &b) {
     }
 
     // Compare all digits
-    for (long i = a.m_digits.size() - 1; i >= 0; --i) {
-        if (a.m_digits[i] > b.m_digits[i]) {
-            return !a.m_is_positive;
-        } else if (a.m_digits[i] < b.m_digits[i]) {
-            return a.m_is_positive;
-        }
-    }
-
-    // Otherwise, numbers are equal
-    return false;
+    const int order = cmp(a.m_digits.data(), b.m_digits.data(), a.m_digits.size());
+    return a.m_is_positive ? order < 0 : order > 0;
 }
 
 bool operator==(const BigInteger &a, const BigInteger &b) {
     // If order of numbers or signs differ then they are not equal
     if (a.m_digits.size() != b.m_digits.size() || a.m_is_positive != b.m_is_positive) return false;
 
-    // Compare all digits until we find different digits
-    for (size_t i = 0; i < a.m_digits.size(); ++i) {
-        if (a.m_digits[i] != b.m_digits[i]) {
-            return false;
-        }
+    return cmp(a.m_digits.data(), b.m_digits.data(), a.m_digits.size()) == 0;
+}
+
+BigInteger &BigInteger::operator>>=(const BigInteger &b) {
+    return shift_right(shift_count(b));
+}
+
+BigInteger &BigInteger::operator<<=(const BigInteger &b) {
+    return shift_left(shift_count(b));
+}
+
+BigInteger operator~(BigInteger a) {
+    a.change_sign();
+    --a;
+    return a;
+}
+
+void BigInteger::add_abs(const limb_t *b, size_t bn) {
+    // Make sure we have enough space to sum carry
+    const size_t n = max(m_digits.size(), bn);
+    m_digits.resize(n + 1, 0);
+    add_in_place(m_digits.data(), n + 1, b, bn);
+    remove_high_order_zeros();
+}
+
+void BigInteger::subtract_abs(const limb_t *b, size_t bn) {
+    const size_t n = m_digits.size();
+    if (n < bn || (n == bn && cmp(m_digits.data(), b, n) < 0)) {
+        // |*this| = b - |*this|, the digits are subtracted from b in place
+        m_digits.resize(bn, 0);
+        sub_n(m_digits.data(), b, m_digits.data(), bn);
+        change_sign();
+    } else {
+        sub_in_place(m_digits.data(), n, b, bn);
     }
+    remove_high_order_zeros();
+    check_zero_sign();
+}
 
-    // Otherwise, numbers are equal
-    return true;
+BigInteger &BigInteger::add_signed(const limb_t *b, size_t bn, bool b_is_positive) {
+    if (m_is_positive == b_is_positive) {
+        add_abs(b, bn);
+    } else {
+        subtract_abs(b, bn);
+    }
+    return *this;
 }
 
-BigInteger &BigInteger::operator>>=(const BigInteger &b) {
-    if (!b.m_is_positive) {
-        throw std::invalid_argument("Сan't bitshift to a negative number");
+// Counters are hot, so the carry is propagated inline instead of calling add_in_place()
+void BigInteger::increment_abs() {
+    for (auto &digit : m_digits) {
+        if (++digit != 0) {
+            return;
+        }
     }
-    if (!m_is_positive) {
-        *this = ~(*this);
-        *this >>= b;
-        *this = ~(*this);
-        return *this;
+    m_digits.push_back(1);
+}
+
+void BigInteger::decrement_abs() {
+    for (auto &digit : m_digits) {
+        if (digit-- != 0) {
+            break;
+        }
     }
-    if (b.is_zero()) {
+    remove_high_order_zeros();
+}
+
+BigInteger &BigInteger::add_native(uint64_t b, bool b_is_positive) {
+    const limb_t digits[2] = {(limb_t) mod_by_pow_of_2(b, BASE_POW), (limb_t) div_by_pow_of_2(b, BASE_POW)};
+    return add_signed(digits, digits[1] != 0 ? 2 : 1, b_is_positive);
+}
+
+BigInteger &BigInteger::multiply_native(uint64_t b, bool b_is_positive) {
+    const limb_t digits[2] = {(limb_t) mod_by_pow_of_2(b, BASE_POW), (limb_t) div_by_pow_of_2(b, BASE_POW)};
+    if (digits[1] == 0) {
+        multiply_by_short_number(digits[0]);
+    } else {
+        ScratchFrame frame;
+        const size_t n = m_digits.size() + 2;
+        limb_t *result = frame.alloc(n);
+        mul(result, m_digits.data(), m_digits.size(), digits, 2);
+        assign_digits(result, n);
+    }
+    m_is_positive = m_is_positive == b_is_positive;
+    remove_high_order_zeros();
+    check_zero_sign();
+    return *this;
+}
+
+BigInteger &BigInteger::divide_native(uint64_t b, bool b_is_positive) {
+    if (div_by_pow_of_2(b, BASE_POW) != 0) {
+        // The divisor fits in the inline digits, so it is not allocated
+        BigInteger divisor(b);
+        divisor.m_is_positive = b_is_positive;
+        divide(*this, divisor, this, nullptr);
         return *this;
     }
-    long long b_ll = b.to_long_long();
-    if (!fits_in_size_t(b_ll)) {
-        throw std::range_error("Argument is too big for bitshift");
+    if (b == 0) {
+        throw std::runtime_error("Division by zero.");
     }
+    divide_by_short_number(b);
+    m_is_positive = m_is_positive == b_is_positive;
+    check_zero_sign();
+    return *this;
+}
 
-    size_t digit_shift = b_ll / BASE_POW;
-    uint32_t rem_shift = b_ll % BASE_POW;
-    long long new_size = m_digits.size() - digit_shift;
-    if (new_size <= 0) {
-        *this = 0;
+BigInteger &BigInteger::remainder_native(uint64_t b) {
+    if (div_by_pow_of_2(b, BASE_POW) != 0) {
+        divide(*this, BigInteger(b), nullptr, this);
         return *this;
     }
-    Vector<uint32_t> tmp(new_size, 0);
-    size_t shift = BASE_POW - rem_shift, j = digit_shift, i;
-    uint64_t accum = m_digits[j++] >> rem_shift;
-    for (i = 0; j < m_digits.size(); ++i, ++j) {
-        accum |= (uint64_t) m_digits[j] << shift;
-        tmp[i] = accum;
-        accum >>= BASE_POW;
+    if (b == 0) {
+        throw std::runtime_error("Division by zero.");
     }
-    tmp[i] = accum;
-    m_digits = std::move(tmp);
-
+    double_limb_t remainder = 0;
+    for (size_t i = m_digits.size(); i-- > 0;) {
+        remainder = (mult_by_pow_of_2(remainder, BASE_POW) + m_digits[i]) % b;
+    }
+    m_digits.resize(1);
+    m_digits[0] = remainder;
     check_zero_sign();
-    remove_high_order_zeros();
     return *this;
 }
 
-BigInteger &BigInteger::operator<<=(const BigInteger &b) {
+uint64_t BigInteger::shift_count(const BigInteger &b) {
     if (!b.m_is_positive) {
         throw std::invalid_argument("Сan't bitshift to a negative number");
     }
-    if (b.is_zero()) {
-        return *this;
-    }
     long long b_ll = b.to_long_long();
     if (!fits_in_size_t(b_ll)) {
         throw std::range_error("Argument is too big for bitshift");
     }
+    return b_ll;
+}
 
-    size_t digit_shift = b_ll / BASE_POW;
-    uint32_t rem_shift = b_ll % BASE_POW;
-    Vector<uint32_t> tmp(m_digits.size() + digit_shift + (rem_shift > 0 ? 1 : 0), 0);
-    uint64_t accum = 0;
-    for (size_t i = digit_shift, j = 0; j < m_digits.size(); ++i, ++j) {
-        accum |= (uint64_t) m_digits[j] << rem_shift;
-        tmp[i] = accum;
-        accum >>= BASE_POW;
+uint64_t BigInteger::shift_count(uint64_t b, bool b_is_positive) {
+    if (!b_is_positive && b != 0) {
+        throw std::invalid_argument("Сan't bitshift to a negative number");
     }
-    if (rem_shift) {
-        tmp[tmp.size() - 1] = accum;
+    return b;
+}
+
+BigInteger &BigInteger::shift_left(uint64_t b) {
+    if (b == 0 || is_zero()) {
+        return *this;
     }
-    m_digits = std::move(tmp);
+    const size_t digit_shift = b / BASE_POW;
+    const unsigned rem_shift = b % BASE_POW;
+    const size_t n = m_digits.size();
+    // The limbs are moved up in place, the buffer is only reallocated when it is too small
+    m_digits.resize(n + digit_shift + 1, 0);
+    limb_t *digits = m_digits.data();
+    digits[n + digit_shift] = lshift(digits + digit_shift, digits, n, rem_shift);
+    zero_limbs(digits, digit_shift);
 
-    check_zero_sign();
     remove_high_order_zeros();
     return *this;
 }
 
-BigInteger operator~(BigInteger a) {
-    a.change_sign();
-    --a;
-    return a;
-}
-
-BigInteger &BigInteger::add_number_with_same_sign(const BigInteger &b) {
-    // Make sure we have enough space to sum carry
-    m_digits.reserve(max(m_digits.size(), b.m_digits.size()) + 1);
-    m_digits.push_back(0);
-
-    // Sum each digit in numbers
-    uint64_t carry = 0;
-    for (size_t i = 0; i < max(m_digits.size(), b.m_digits.size()) || carry != 0; ++i) {
-        if (i == m_digits.size()) {
-            m_digits.push_back(0);
+BigInteger &BigInteger::shift_right(uint64_t b) {
+    if (b == 0) {
+        return *this;
+    }
+    const size_t n = m_digits.size();
+    if (b / BASE_POW >= n) {
+        // Negative numbers are rounded towards minus infinity
+        return *this = m_is_positive ? 0 : -1;
+    }
+    const size_t digit_shift = b / BASE_POW;
+    const unsigned rem_shift = b % BASE_POW;
+    limb_t *digits = m_digits.data();
+    // floor(-a / 2^b) = -(a >> b) - 1 if any of the shifted out bits is set
+    bool inexact = false;
+    if (!m_is_positive) {
+        for (size_t i = 0; i < digit_shift && !inexact; ++i) {
+            inexact = digits[i] != 0;
         }
-        uint64_t digit = (uint64_t) m_digits[i] + (i < b.m_digits.size() ? b.m_digits[i] : 0) + carry;
-        m_digits[i] = mod_by_pow_of_2(digit, BASE_POW);
-        carry = div_by_pow_of_2(digit, BASE_POW);
-
     }
-
+    inexact |= rshift(digits, digits + digit_shift, n - digit_shift, rem_shift) != 0;
+    m_digits.resize(n - digit_shift);
     remove_high_order_zeros();
 
+    if (!m_is_positive && inexact) {
+        increment_abs();
+    }
     check_zero_sign();
     return *this;
 }
 
-BigInteger &BigInteger::subtract_lesser_number_with_same_sign(const BigInteger &b) {
-    // Subtract digits
-    int64_t carry = 0;
-    for (size_t i = 0; i < b.m_digits.size() || carry != 0; ++i) {
-        if (i == m_digits.size()) {
-            m_digits.push_back(0);
-        }
-        int64_t digit = (int64_t) m_digits[i] - (carry + (int64_t) (i < b.m_digits.size() ? b.m_digits[i] : 0));
-        if (digit < 0) {
-            carry = 1;
-            digit += base;
-        } else {
-            carry = 0;
-        }
-        m_digits[i] = digit;
+BigInteger &BigInteger::bitwise_binary_operator(const BigInteger &b, char operation) {
+    if (operation != '&' && operation != '|' && operation != '^') {
+        throw std::invalid_argument("Invalid operation");
+    }
+    const size_t an = m_digits.size(), bn = b.m_digits.size();
+    m_digits.resize(max(an, bn) + 1, 0);
+    // Taken after the resize, b may be *this
+    limb_t *r = m_digits.data();
+    const limb_t *b_digits = b.m_digits.data();
+    bool result_is_negative;
+    if (an >= bn) {
+        result_is_negative = bitwise_signed(r, r, an, !m_is_positive, b_digits, bn, !b.m_is_positive, operation);
+    } else {
+        result_is_negative = bitwise_signed(r, b_digits, bn, !b.m_is_positive, r, an, !m_is_positive, operation);
     }
+    m_is_positive = !result_is_negative;
 
     remove_high_order_zeros();
-
     check_zero_sign();
     return *this;
 }
 
-BigInteger &BigInteger::bitwise_binary_operator(BigInteger b, char operation) {
-    size_t digits_to_handle = max(m_digits.size(), b.m_digits.size());
-    m_digits.resize(digits_to_handle, 0);
-    make_twos_complement_form();
-    b.m_digits.resize(digits_to_handle, 0);
-    b.make_twos_complement_form();
+size_t BigInteger::bit_length() const {
+    const size_t n = m_digits.size();
+    size_t length = (n - 1) * BASE_POW + std::bit_width(m_digits.back());
+    // |a| - 1 is a bit shorter if |a| is a power of two
+    if (!m_is_positive && std::has_single_bit(m_digits.back()) && lowest_nonzero_digit() == n - 1) {
+        --length;
+    }
+    return length;
+}
 
-    switch (operation) {
-        case '&':
-            for (size_t i = 0; i < digits_to_handle; ++i) {
-                m_digits[i] = m_digits[i] & b.m_digits[i];
-            }
-            m_is_positive = m_is_positive || b.m_is_positive;
-            break;
-        case '|':
-            for (size_t i = 0; i < digits_to_handle; ++i) {
-                m_digits[i] = m_digits[i] | b.m_digits[i];
-            }
-            m_is_positive = m_is_positive && b.m_is_positive;
-            break;
-        case '^':
-            for (size_t i = 0; i < digits_to_handle; ++i) {
-                m_digits[i] = m_digits[i] ^ b.m_digits[i];
-            }
-            m_is_positive = m_is_positive == b.m_is_positive;
-            break;
-        default:
-            throw std::invalid_argument("Invalid operation");
+size_t BigInteger::popcount() const {
+    size_t count = popcount_n(m_digits.data(), m_digits.size());
+    if (!m_is_positive) {
+        // The bits of ~(|a| - 1) that are 0: |a| - 1 has the lowest set bit of |a| cleared and all bits below it set
+        count = count - 1 + count_trailing_zeros();
     }
-    make_twos_complement_form();
+    return count;
+}
 
-    remove_high_order_zeros();
-    check_zero_sign();
+size_t BigInteger::count_trailing_zeros() const {
+    if (is_zero()) {
+        return 0;
+    }
+    const size_t i = lowest_nonzero_digit();
+    return i * BASE_POW + std::countr_zero(m_digits[i]);
+}
+
+bool BigInteger::test_bit(size_t n) const {
+    const size_t i = n / BASE_POW;
+    if (i >= m_digits.size()) {
+        return !m_is_positive;
+    }
+    limb_t digit = m_digits[i];
+    if (!m_is_positive) {
+        // The two's complement limbs are -digit up to the lowest nonzero limb and ~digit above it
+        digit = i <= lowest_nonzero_digit() ? 0 - digit : ~digit;
+    }
+    return (digit >> (n % BASE_POW)) & 1;
+}
+
+BigInteger &BigInteger::set_bit(size_t n) {
+    return change_bit(n, '|');
+}
+
+BigInteger &BigInteger::clear_bit(size_t n) {
+    return change_bit(n, '&');
+}
+
+BigInteger &BigInteger::flip_bit(size_t n) {
+    return change_bit(n, '^');
+}
+
+BigInteger &BigInteger::change_bit(size_t n, char operation) {
+    if (m_is_positive) {
+        change_abs_bit(n, operation);
+        return *this;
+    }
+    // The form of a negative number is ~(|a| - 1), so the bit of |a| - 1 is changed the opposite way
+    decrement_abs();
+    change_abs_bit(n, operation == '|' ? '&' : operation == '&' ? '|' : '^');
+    increment_abs();
     return *this;
 }
 
+void BigInteger::change_abs_bit(size_t n, char operation) {
+    const size_t i = n / BASE_POW;
+    const limb_t bit = (limb_t) 1 << (n % BASE_POW);
+    if (i >= m_digits.size()) {
+        if (operation == '&') {
+            return;
+        }
+        m_digits.resize(i + 1, 0);
+    }
+    limb_t &digit = m_digits[i];
+    digit = operation == '|' ? digit | bit : operation == '&' ? digit & ~bit : digit ^ bit;
+    remove_high_order_zeros();
+}
+
+size_t BigInteger::lowest_nonzero_digit() const {
+    size_t i = 0;
+    while (m_digits[i] == 0) {
+        ++i;
+    }
+    return i;
+}
+
 bool BigInteger::is_zero() const {
     return m_digits.size() == 1 && m_digits.back() == 0;
 }
@@ -466,13 +716,15 @@ bool BigInteger::is_negative_one() const {
     return !m_is_positive && m_digits.size() == 1 && m_digits.back() == 1;
 }
 
-BigInteger &BigInteger::multiply_by_short_number(uint32_t number) {
-    uint64_t carry = 0;
-    for (auto & m_digit : m_digits) {
-        uint64_t digit = m_digit * (uint64_t) number + carry;
-        m_digit = mod_by_pow_of_2(digit, BASE_POW);
-        carry = div_by_pow_of_2(digit, BASE_POW);
-    }
+bool BigInteger::is_abs_equal(const BigInteger &b) const {
+    // High digits differ more often, cmp() compares them first
+    return m_digits.size() == b.m_digits.size() && cmp(m_digits.data(), b.m_digits.data(), m_digits.size()) == 0;
+}
+
+BigInteger &BigInteger::multiply_by_short_number(limb_t number, limb_t addend) {
+    limb_t *digits = m_digits.data();
+    limb_t carry = mul_1(digits, digits, m_digits.size(), number);
+    carry += add_in_place(digits, m_digits.size(), &addend, 1);
     if (carry != 0) {
         m_digits.push_back(carry);
     }
@@ -480,33 +732,15 @@ BigInteger &BigInteger::multiply_by_short_number(uint32_t number) {
     return *this;
 }
 
-uint32_t BigInteger::divide_by_short_number(uint32_t number) {
+limb_t BigInteger::divide_by_short_number(limb_t number) {
     // returns the remainder of the division
 
     if (number == 0) {
         throw std::runtime_error("Division by zero");
     }
-    if (number < 0) {
-        change_sign();
-        number = -number;
-    }
-    uint64_t carry = 0, digit;
-    for (long i = m_digits.size() - 1; i >= 0; --i) {
-        digit = m_digits[i] + mult_by_pow_of_2(carry, BASE_POW);
-        m_digits[i] = digit / number;
-        carry = digit % number;
-    }
+    const limb_t remainder = divrem_1(m_digits.data(), m_digits.data(), m_digits.size(), number);
     remove_high_order_zeros();
-    return carry;
-}
-
-void BigInteger::make_twos_complement_form() {
-    if (!m_is_positive) {
-        for (size_t i = 0; i < m_digits.size(); ++i) {
-            m_digits[i] = ~m_digits[i];
-        }
-        --(*this);
-    }
+    return remainder;
 }
 
 void BigInteger::check_zero_sign() {
@@ -514,6 +748,14 @@ void BigInteger::check_zero_sign() {
     if (is_zero()) m_is_positive = true;
 }
 
+void BigInteger::assign_digits(const limb_t *digits, size_t n) {
+    while (n > 1 && digits[n - 1] == 0) {
+        --n;
+    }
+    m_digits.resize(n);
+    std::copy(digits, digits + n, m_digits.data());
+}
+
 void BigInteger::remove_high_order_zeros() {
     while (m_digits.size() > 1 && m_digits.back() == 0) {
         m_digits.pop_back();
@@ -521,31 +763,205 @@ void BigInteger::remove_high_order_zeros() {
 }
 
 long long BigInteger::to_long_long() const {
-    switch (m_digits.size()) {
-        case 1:
-            return m_digits[0];
-            break;
-        case 2:
-            return ((long long) m_digits[1] << 32) | (long long) m_digits[0];
-        default:
-            throw std::range_error("This BigInteger can't be represented as unsigned long long");
+    if (m_digits.size() * BASE_POW > 64) {
+        throw std::range_error("This BigInteger can't be represented as unsigned long long");
     }
+    double_limb_t result = 0;
+    for (size_t i = m_digits.size(); i-- > 0;) {
+        result = mult_by_pow_of_2(result, BASE_POW) | m_digits[i];
+    }
+    return (long long) result;
 }
 
-std::string to_string(const BigInteger &n) {
-    BigInteger num = n; // We create a copy of a number to divide it by 10 for translation;
-    std::string result; // vector for storing result digits (they will be stored here in reverse order)
+bool BigInteger::write_radix(char *out, size_t width, int radix) const {
+    const RadixChunk chunk = radix_chunk(radix);
+    if (m_digits.size() <= radix_conversion_threshold) {
+        BigInteger num = *this;
+        char *digit = out + width;
+        limb_t chunk_value = 0;
+        while (digit > out && !num.is_zero()) {
+            chunk_value = num.divide_by_short_number(chunk.base);
+            if (radix == 10) {
+                digit = write_chunk(digit, out, chunk_value, chunk.digits, std::integral_constant<int, 10>());
+            } else {
+                digit = write_chunk(digit, out, chunk_value, chunk.digits, radix);
+            }
+        }
+        while (digit > out) {
+            *--digit = '0';
+        }
+        return num.is_zero() && chunk_value == 0;
+    }
+
+    // Split by the smallest cached power of the radix that takes at least half of the digits
+    size_t i = 0;
+    while (2 * (chunk.digits << i) < width) {
+        ++i;
+    }
+    const size_t low_width = chunk.digits << i;
+    const BigInteger &power = radix_power(radix, i);
+
+    BigInteger high, low;
+    div_mod(*this, power, high, low);
+    // The low part always fits
+    low.write_radix(out + width - low_width, low_width, radix);
+    return high.write_radix(out, width - low_width, radix);
+}
+
+void BigInteger::write_power_of_two_radix(char *out, size_t width, int radix) const {
+    const unsigned bits = std::countr_zero((unsigned) radix);
+    const limb_t mask = radix - 1;
+    const size_t n = m_digits.size();
+    size_t position = 0;
+    for (char *digit = out + width; digit-- > out; position += bits) {
+        const size_t limb = position / BASE_POW;
+        const unsigned shift = position % BASE_POW;
+        limb_t value = limb < n ? m_digits[limb] >> shift : 0;
+        if (shift + bits > BASE_POW && limb + 1 < n) {
+            value |= m_digits[limb + 1] << (BASE_POW - shift);
+        }
+        *digit = digit_char(value & mask, radix);
+    }
+}
+
+// The width of the digits is an upper bound, the leading zeros are removed. Returns the end of the digits.
+static char *remove_leading_zeros(char *out, size_t width) {
+    size_t begin = 0;
+    while (begin + 1 < width && out[begin] == '0') {
+        ++begin;
+    }
+    std::memmove(out, out + begin, width - begin);
+    return out + width - begin;
+}
+
+size_t BigInteger::abs_bit_length() const {
+    return (m_digits.size() - 1) * BASE_POW + std::bit_width(m_digits.back());
+}
+
+size_t BigInteger::max_digits(int radix) const {
+    const size_t bits = abs_bit_length();
+    if (is_power_of_two_radix(radix)) {
+        return max<size_t>(div_with_rounding_up<size_t>(bits, std::countr_zero((unsigned) radix)), 1);
+    }
+    return (size_t) (bits / std::log2(radix)) + 2;
+}
 
-    const uint32_t res_base = 10;
-    while (num.m_digits.size() > 1 || num.m_digits.front() >= res_base) {
-        uint32_t remainder = num.divide_by_short_number(10);
-        result.push_back('0' + (char) remainder);
+char *BigInteger::write_chars(char *out, int radix) const {
+    if (!m_is_positive) {
+        *out++ = '-';
+    }
+    const size_t width = max_digits(radix);
+    if (is_power_of_two_radix(radix)) {
+        write_power_of_two_radix(out, width, radix);
+        return out + width;
+    }
+    write_radix(out, width, radix);
+    return remove_leading_zeros(out, width);
+}
+
+size_t to_chars_max_size(const BigInteger &num, int base) {
+    if (!is_supported_radix(base)) {
+        throw std::invalid_argument("Unsupported radix");
+    }
+    return (num.m_is_positive ? 0 : 1) + num.max_digits(base);
+}
+
+std::to_chars_result to_chars(char *first, char *last, const BigInteger &num, int base) {
+    const size_t size = to_chars_max_size(num, base);
+    const size_t available = last - first;
+    if (available >= size) {
+        return {num.write_chars(first, base), std::errc()};
+    }
+
+    // The bound is exact for power-of-two radixes. For the others the number has one or two digits less,
+    // then as many digits as fit are written, and the conversion fails if some digits are left.
+    const size_t sign = num.m_is_positive ? 0 : 1;
+    if (is_power_of_two_radix(base) || available + 2 < size || available <= sign) {
+        return {last, std::errc::value_too_large};
+    }
+    if (!num.write_radix(first + sign, available - sign, base)) {
+        return {last, std::errc::value_too_large};
+    }
+    if (sign) {
+        *first = '-';
+    }
+    return {remove_leading_zeros(first + sign, available - sign), std::errc()};
+}
+
+std::from_chars_result from_chars(const char *first, const char *last, BigInteger &value, int base) {
+    if (!is_supported_radix(base)) {
+        throw std::invalid_argument("Unsupported radix");
+    }
+    const char *digits = first != last && *first == '-' ? first + 1 : first;
+    const char *end = digits;
+    while (end != last && digit_value(*end, base) >= 0) {
+        ++end;
+    }
+    if (end == digits) {
+        return {first, std::errc::invalid_argument};
+    }
+    value.parse(std::string_view(first, end - first), base);
+    return {end, std::errc()};
+}
+
+std::string to_string(const BigInteger &num, int radix) {
+    std::string result(to_chars_max_size(num, radix), '-');
+    result.resize(num.write_chars(result.data(), radix) - result.data());
+    return result;
+}
+
+std::ostream &operator<<(std::ostream &out, const BigInteger &num) {
+    // Usual numbers are written from the stack
+    char buffer[256];
+    if (to_chars_max_size(num, 10) <= sizeof(buffer)) {
+        // A string_view keeps the width and fill of the stream
+        out << std::string_view(buffer, num.write_chars(buffer, 10) - buffer);
+    } else {
+        out << to_string(num);
     }
-    result.push_back('0' + (char) num.m_digits.front());
+    return out;
+}
 
-    if (!n.m_is_positive) {
-        result.push_back('-');
+BigInteger &BigInteger::import_bytes(const uint8_t *data, size_t n, std::endian order) {
+    m_is_positive = true;
+    m_digits.resize(max<size_t>(div_with_rounding_up(n, sizeof(limb_t)), 1));
+    limb_t *digits = m_digits.data();
+    zero_limbs(digits, m_digits.size());
+    if (order == std::endian::native && std::endian::native == std::endian::little) {
+        // data may be null when n is 0
+        if (n > 0) {
+            std::memcpy(digits, data, n);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            const uint8_t byte = order == std::endian::little ? data[i] : data[n - 1 - i];
+            digits[i / sizeof(limb_t)] |= (limb_t) byte << (8 * (i % sizeof(limb_t)));
+        }
     }
+    remove_high_order_zeros();
+    return *this;
+}
+
+size_t BigInteger::byte_count() const {
+    return div_with_rounding_up<size_t>(abs_bit_length(), 8);
+}
 
-    return {result.rbegin(), result.rend()};
+size_t BigInteger::export_bytes(uint8_t *out, std::endian order) const {
+    const size_t n = byte_count();
+    if (order == std::endian::native && std::endian::native == std::endian::little) {
+        // out may be null when the number is 0
+        if (n > 0) {
+            std::memcpy(out, m_digits.data(), n);
+        }
+        return n;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t byte = m_digits[i / sizeof(limb_t)] >> (8 * (i % sizeof(limb_t)));
+        out[order == std::endian::little ? i : n - 1 - i] = byte;
+    }
+    return n;
+}
+
+std::string to_string(const BigInteger &n) {
+    return to_string(n, 10);
 }
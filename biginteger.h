@@ -1,20 +1,28 @@
 #pragma once
 
+#include <bit>
+#include <charconv>
+#include <concepts>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include "Vector.h"
 #include "helpers.h"
-
-#define BASE_POW 32
+#include "multiplication.h"
+#include "division.h"
 
 //--------------------------------
 // BigInteger
 //--------------------------------
 class BigInteger {
-    static constexpr uint64_t base = 1ull << BASE_POW;
+    // Numbers of up to inline_digits limbs are stored without heap allocations
+    static constexpr size_t inline_digits = 4;
+    using Digits = Vector<limb_t, inline_digits>;
 
     bool m_is_positive;
-    Vector<uint32_t> m_digits;
+    Digits m_digits;
 
 public:
 
@@ -35,9 +43,10 @@ public:
     BigInteger(unsigned long num) : BigInteger((unsigned long long) num) {}
 
     BigInteger(long long num) : m_is_positive(num >= 0), m_digits(2) {
-        num = abs(num);
-        m_digits.push_back(mod_by_pow_of_2(num, BASE_POW));
-        m_digits.push_back(div_by_pow_of_2(num, BASE_POW));
+        // negated in the unsigned type, -LLONG_MIN doesn't fit in long long
+        const uint64_t abs_num = num < 0 ? 0 - (uint64_t) num : (uint64_t) num;
+        m_digits.push_back(mod_by_pow_of_2(abs_num, BASE_POW));
+        m_digits.push_back(div_by_pow_of_2(abs_num, BASE_POW));
         remove_high_order_zeros();
     }
 
@@ -47,8 +56,15 @@ public:
         remove_high_order_zeros();
     }
 
-    // constructor from string
-    explicit BigInteger(const std::string &s);
+    // constructors from string
+    explicit BigInteger(std::string_view s);
+
+    explicit BigInteger(const char *s) : BigInteger(std::string_view(s)) {}
+
+    explicit BigInteger(const char *s, size_t n) : BigInteger(std::string_view(s, n)) {}
+
+    // parses s in a radix from 2 to 36 or 64, see digit_value() for the digits
+    static BigInteger from_string(std::string_view s, int radix);
 
     // copy and move constructors
     BigInteger(const BigInteger &num);
@@ -85,6 +101,9 @@ public:
         return a;
     };
 
+    // squares the number in place, it's faster than a multiplication by another number
+    BigInteger &square();
+
     BigInteger &operator/=(const BigInteger &b);
 
     friend BigInteger operator/(BigInteger a, const BigInteger &b) {
@@ -99,6 +118,63 @@ public:
         return a;
     };
 
+    // operators with native integers work in place without converting them to BigInteger
+    template<std::integral T>
+    BigInteger &operator+=(T b) { return add_native(abs_value(b), !is_negative(b)); }
+
+    template<std::integral T>
+    BigInteger &operator-=(T b) { return add_native(abs_value(b), is_negative(b)); }
+
+    template<std::integral T>
+    BigInteger &operator*=(T b) { return multiply_native(abs_value(b), !is_negative(b)); }
+
+    template<std::integral T>
+    BigInteger &operator/=(T b) { return divide_native(abs_value(b), !is_negative(b)); }
+
+    template<std::integral T>
+    BigInteger &operator%=(T b) { return remainder_native(abs_value(b)); }
+
+    template<std::integral T>
+    friend BigInteger operator+(BigInteger a, T b) {
+        a += b;
+        return a;
+    }
+
+    template<std::integral T>
+    friend BigInteger operator-(BigInteger a, T b) {
+        a -= b;
+        return a;
+    }
+
+    template<std::integral T>
+    friend BigInteger operator*(BigInteger a, T b) {
+        a *= b;
+        return a;
+    }
+
+    template<std::integral T>
+    friend BigInteger operator/(BigInteger a, T b) {
+        a /= b;
+        return a;
+    }
+
+    template<std::integral T>
+    friend BigInteger operator%(BigInteger a, T b) {
+        a %= b;
+        return a;
+    }
+
+    // returns {*this / b, *this % b} computed by a single division,
+    // the quotient is truncated towards zero and the remainder has the sign of *this
+    std::pair<BigInteger, BigInteger> divmod(const BigInteger &b) const;
+
+    // q = a / b, r = a % b, q and r may be the same objects as a and b but not as each other
+    friend void div_mod(const BigInteger &a, const BigInteger &b, BigInteger &q, BigInteger &r);
+
+    // base^exp mod |mod| in [0, |mod|) by the sliding-window method with Montgomery reduction for odd moduli
+    // and Barrett reduction for even ones. Throws std::invalid_argument if exp is negative.
+    friend BigInteger pow_mod(const BigInteger &base, const BigInteger &exp, const BigInteger &mod);
+
     // unary operators
     friend BigInteger operator+(const BigInteger &a);
 
@@ -182,19 +258,126 @@ public:
         return a;
     }
 
+    // shifts by a native count in place, throw std::invalid_argument for negative counts.
+    // The right shift of negative numbers is arithmetic (rounds towards minus infinity).
+    template<std::integral T>
+    BigInteger &operator>>=(T b) { return shift_right(shift_count(abs_value(b), !is_negative(b))); }
+
+    template<std::integral T>
+    BigInteger &operator<<=(T b) { return shift_left(shift_count(abs_value(b), !is_negative(b))); }
+
+    template<std::integral T>
+    friend BigInteger operator>>(BigInteger a, T b) {
+        a >>= b;
+        return a;
+    }
+
+    template<std::integral T>
+    friend BigInteger operator<<(BigInteger a, T b) {
+        a <<= b;
+        return a;
+    }
+
     // unary operators
     friend BigInteger operator~(BigInteger a);
 
+    //--------------------------------
+    // Bit queries
+    //--------------------------------
+    // Negative numbers are seen in the infinite two's complement form, like in java.math.BigInteger
+
+    // length of the shortest two's complement form without the sign bit, 0 for 0 and -1
+    [[nodiscard]] size_t bit_length() const;
+
+    // number of bits that differ from the sign bit
+    [[nodiscard]] size_t popcount() const;
+
+    // index of the lowest set bit, 0 for 0
+    [[nodiscard]] size_t count_trailing_zeros() const;
+
+    [[nodiscard]] bool test_bit(size_t n) const;
+
+    BigInteger &set_bit(size_t n);
+
+    BigInteger &clear_bit(size_t n);
+
+    BigInteger &flip_bit(size_t n);
+
+    //--------------------------------
+    // Byte import and export
+    //--------------------------------
+    // Like mpz_import and mpz_export in GMP, only the absolute value is exported.
+    // Without conversion if the order is the native one.
+
+    // sets *this to the non-negative number given by data[0, n) in the given byte order
+    BigInteger &import_bytes(const uint8_t *data, size_t n, std::endian order = std::endian::little);
+
+    // number of bytes in |*this|, 0 for 0
+    [[nodiscard]] size_t byte_count() const;
+
+    // writes the byte_count() bytes of |*this| in the given order to out, returns their number
+    size_t export_bytes(uint8_t *out, std::endian order = std::endian::little) const;
+
 private:
 
     //--------------------------------
     // Private methods
     //--------------------------------
-    BigInteger &add_number_with_same_sign(const BigInteger &b);
+    // |*this| += b[0, bn)
+    void add_abs(const limb_t *b, size_t bn);
+
+    // |*this| -= b[0, bn), if |*this| < b then |*this| = b - |*this| and the sign is changed
+    void subtract_abs(const limb_t *b, size_t bn);
+
+    // *this += b[0, bn) taken with the given sign, b must not be the digits of *this
+    BigInteger &add_signed(const limb_t *b, size_t bn, bool b_is_positive);
+
+    void increment_abs();
+
+    // requires *this != 0
+    void decrement_abs();
+
+    // operations with a native number given by its absolute value and sign
+    BigInteger &add_native(uint64_t b, bool b_is_positive);
+
+    BigInteger &multiply_native(uint64_t b, bool b_is_positive);
 
-    BigInteger &subtract_lesser_number_with_same_sign(const BigInteger &b);
+    BigInteger &divide_native(uint64_t b, bool b_is_positive);
 
-    BigInteger &bitwise_binary_operator(BigInteger b, char operation);
+    BigInteger &remainder_native(uint64_t b);
+
+    // validates a shift count, throws std::invalid_argument if it is negative
+    static uint64_t shift_count(const BigInteger &b);
+
+    static uint64_t shift_count(uint64_t b, bool b_is_positive);
+
+    BigInteger &shift_left(uint64_t b);
+
+    BigInteger &shift_right(uint64_t b);
+
+    template<std::integral T>
+    static bool is_negative(T num) {
+        if constexpr (std::is_signed_v<T>) {
+            return num < 0;
+        }
+        return false;
+    }
+
+    template<std::integral T>
+    static uint64_t abs_value(T num) {
+        return is_negative(num) ? 0 - (uint64_t) num : (uint64_t) num;
+    }
+
+    // works on the two's complement forms limb by limb without converting the operands
+    BigInteger &bitwise_binary_operator(const BigInteger &b, char operation);
+
+    // changes bit n of the two's complement form by operation '|' (set), '&' (clear) or '^' (flip)
+    BigInteger &change_bit(size_t n, char operation);
+
+    void change_abs_bit(size_t n, char operation);
+
+    // requires *this != 0
+    size_t lowest_nonzero_digit() const;
 
     bool is_zero() const;
 
@@ -202,16 +385,52 @@ private:
 
     bool is_negative_one() const;
 
-    BigInteger &multiply_by_short_number(uint32_t number);
+    bool is_abs_equal(const BigInteger &b) const;
 
-    uint32_t divide_by_short_number(uint32_t number);
+    // *this = *this * number + addend
+    BigInteger &multiply_by_short_number(limb_t number, limb_t addend = 0);
 
-    void make_twos_complement_form();
+    limb_t divide_by_short_number(limb_t number);
 
     void check_zero_sign();
 
     void remove_high_order_zeros();
 
+    // copies the limbs without the high zeros, the buffer is reused if it is large enough
+    void assign_digits(const limb_t *digits, size_t n);
+
+    // q = a / b and r = a % b, where the outputs may be nullptr or the same objects as a and b
+    static void divide(const BigInteger &a, const BigInteger &b, BigInteger *q, BigInteger *r);
+
+    // writes the lowest width digits of |*this| padded with zeros, returns false if it has more digits
+    bool write_radix(char *out, size_t width, int radix) const;
+
+    static BigInteger parse_radix(const char *s, size_t n, int radix);
+
+    // base^(2^i) for the chunk base of the radix (the largest power of the radix that fits in a limb)
+    static const BigInteger &radix_power(int radix, size_t i);
+
+    // number of digits in radix_power(radix, i), the power is radix^digits
+    static size_t radix_power_digits(int radix, size_t i);
+
+    // parses an optional sign and the digits
+    void parse(std::string_view s, int radix);
+
+    // radix is a power of two, every digit goes straight to its bits
+    void parse_power_of_two_radix(const char *s, size_t n, int radix);
+
+    // writes exactly width digits of |*this| padded with zeros
+    void write_power_of_two_radix(char *out, size_t width, int radix) const;
+
+    // number of bits in |*this|
+    size_t abs_bit_length() const;
+
+    // upper bound of the number of digits in the radix
+    size_t max_digits(int radix) const;
+
+    // writes the sign and the digits to out that has room for to_chars_max_size() chars, returns the end
+    char *write_chars(char *out, int radix) const;
+
     [[nodiscard]] long long to_long_long() const;
 
     inline void change_sign() { m_is_positive = !m_is_positive; }
@@ -219,11 +438,48 @@ private:
     //--------------------------------
     // Non-member functions
     //--------------------------------
-    friend std::ostream &operator<<(std::ostream &out, const BigInteger &num) {
-        out << to_string(num);
-        return out;
-    };
+    friend std::ostream &operator<<(std::ostream &out, const BigInteger &num);
 
     friend std::string to_string(const BigInteger &num);
 
+    // radix from 2 to 36 or 64, without a prefix
+    friend std::string to_string(const BigInteger &num, int radix);
+
+    // Like std::to_chars: writes num to [first, last) without a terminating zero, or returns
+    // std::errc::value_too_large if it doesn't fit. Throws std::invalid_argument for an unsupported base.
+    friend std::to_chars_result to_chars(char *first, char *last, const BigInteger &num, int base);
+
+    // An upper bound of the number of chars in num including the sign, a buffer of this size always fits it
+    friend size_t to_chars_max_size(const BigInteger &num, int base);
+
+    // Like std::from_chars: parses an optional '-' and the longest sequence of digits. If there are no digits,
+    // returns std::errc::invalid_argument and value is unchanged. For power-of-two radixes the digits are written
+    // into the buffer of value, for the others value takes over a new buffer.
+    friend std::from_chars_result from_chars(const char *first, const char *last, BigInteger &value, int base);
+
+    friend class Reciprocal;
+
+    friend class MontgomeryContext;
+
+    friend class DecimalParser;
+
 };
+
+BigInteger pow_mod(const BigInteger &base, const BigInteger &exp, const BigInteger &mod);
+
+std::to_chars_result to_chars(char *first, char *last, const BigInteger &num, int base = 10);
+
+size_t to_chars_max_size(const BigInteger &num, int base = 10);
+
+std::from_chars_result from_chars(const char *first, const char *last, BigInteger &value, int base = 10);
+
+// base^exp, the result is grown by squarings
+BigInteger pow(const BigInteger &base, uint64_t exp);
+
+template<std::integral P>
+inline BigInteger pow(const BigInteger &base, P exp) {
+    if (exp < 0) {
+        throw std::invalid_argument("Exponent must be non-negative.");
+    }
+    return pow(base, (uint64_t) exp);
+}
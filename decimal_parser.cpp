@@ -0,0 +1,122 @@
+#include "decimal_parser.h"
+
+size_t DecimalParser::block_digits() {
+    return BigInteger::radix_power_digits(10, block_level);
+}
+
+DecimalParser::DecimalParser() {
+    m_block.reserve(block_digits());
+}
+
+void DecimalParser::feed(std::span<const char> chunk) {
+    const char *s = chunk.data();
+    size_t n = chunk.size();
+    if (!m_is_started && n > 0) {
+        m_is_started = true;
+        if (*s == '-') {
+            m_is_negative = true;
+            ++s;
+            --n;
+        }
+    }
+
+    // The chars of a partial block are parsed later, so all of them are checked here
+    for (size_t i = 0; i < n; ++i) {
+        if (digit_value(s[i], 10) < 0) {
+            reset();
+            throw std::invalid_argument("string contains non-digit char");
+        }
+    }
+
+    const size_t size = block_digits();
+    try {
+        while (n > 0) {
+            // Full blocks are parsed straight from the chunk, the rest waits for the next chunks
+            if (m_block.empty() && n >= size) {
+                push_block(s);
+                s += size;
+                n -= size;
+                continue;
+            }
+            const size_t count = min(n, size - m_block.size());
+            m_block.append(s, count);
+            s += count;
+            n -= count;
+            if (m_block.size() == size) {
+                push_block(m_block.data());
+                m_block.clear();
+            }
+        }
+    } catch (...) {
+        reset();
+        throw;
+    }
+}
+
+BigInteger DecimalParser::finish() {
+    bool has_digits = !m_block.empty();
+    for (size_t i = 0; i < max_slots; ++i) {
+        has_digits = has_digits || m_is_used[i];
+    }
+    if (!has_digits) {
+        reset();
+        throw std::invalid_argument("string should have at least 1 digit");
+    }
+
+    // The highest slot has the first digits
+    BigInteger result;
+    try {
+        bool is_first = true;
+        for (size_t i = max_slots; i-- > 0;) {
+            if (!m_is_used[i]) {
+                continue;
+            }
+            if (is_first) {
+                result = std::move(m_slots[i]);
+                is_first = false;
+            } else {
+                result *= BigInteger::radix_power(10, block_level + i);
+                result += m_slots[i];
+            }
+        }
+        if (!m_block.empty()) {
+            result *= pow(BigInteger(10), m_block.size());
+            result += BigInteger::parse_radix(m_block.data(), m_block.size(), 10);
+        }
+    } catch (...) {
+        reset();
+        throw;
+    }
+    if (m_is_negative) {
+        result.change_sign();
+        result.check_zero_sign();
+    }
+    reset();
+    return result;
+}
+
+void DecimalParser::push_block(const char *s) {
+    BigInteger value = BigInteger::parse_radix(s, block_digits(), 10);
+    // Like an increment of a binary counter: equal values are joined while the slots are used
+    size_t i = 0;
+    while (m_is_used[i]) {
+        m_slots[i] *= BigInteger::radix_power(10, block_level + i);
+        m_slots[i] += value;
+        value = std::move(m_slots[i]);
+        m_slots[i] = BigInteger();
+        m_is_used[i] = false;
+        ++i;
+    }
+    m_slots[i] = std::move(value);
+    m_is_used[i] = true;
+}
+
+void DecimalParser::reset() {
+    for (size_t i = 0; i < max_slots; ++i) {
+        m_slots[i] = BigInteger();
+        m_is_used[i] = false;
+    }
+    m_block.clear();
+    m_is_started = false;
+    m_is_negative = false;
+}
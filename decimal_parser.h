@@ -0,0 +1,42 @@
+#pragma once
+
+#include <span>
+#include "biginteger.h"
+
+//--------------------------------
+// DecimalParser
+//--------------------------------
+// Parses a decimal number that comes in chunks, so the whole text never has to be kept in memory.
+// The digits are cut into blocks that are parsed as soon as they are complete. Parsed blocks are merged
+// like a binary counter: slot i keeps the value of 2^i blocks, and two values of the same size are joined
+// by a multiplication by a cached power of 10. The cost is the same as of parsing the whole string at once.
+class DecimalParser {
+    // a block has radix_power_digits(10, block_level) digits
+    static constexpr size_t block_level = 5;
+    static constexpr size_t max_slots = 64;
+
+    BigInteger m_slots[max_slots];
+    bool m_is_used[max_slots] = {};
+    std::string m_block;
+    bool m_is_started = false;
+    bool m_is_negative = false;
+
+public:
+    DecimalParser();
+
+    // Takes the next chars of the number, the first one may be '-'. Throws std::invalid_argument
+    // if the chunk has a char that isn't a digit, then the parser is reset as after finish().
+    void feed(std::span<const char> chunk);
+
+    // Returns the number and resets the parser for the next one.
+    // Throws std::invalid_argument if there were no digits.
+    BigInteger finish();
+
+private:
+    static size_t block_digits();
+
+    // adds the value of a full block of the lowest digits
+    void push_block(const char *s);
+
+    void reset();
+};
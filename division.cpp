@@ -0,0 +1,164 @@
+#include <bit>
+#include "division.h"
+#include "multiplication.h"
+#include "helpers.h"
+#include "limbs.h"
+#include "scratch.h"
+
+DivThresholds div_thresholds;
+
+// Recursion needs at least 4 quotient limbs, so that the halves of the divisor are at least 2 limbs long
+static const size_t min_recursive_size = 4;
+
+//--------------------------------
+// Schoolbook division
+//--------------------------------
+// Knuth's Algorithm D. Requires an >= bn >= 2 and the high bit of b[bn - 1] set.
+// q[0, an - bn) = a / b, returns the high limb of the quotient (0 or 1), a[0, bn) = a % b.
+static limb_t divrem_basecase(limb_t *q, limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    const size_t m = an - bn;
+    const double_limb_t base = mult_by_pow_of_2(1, BASE_POW);
+
+    const limb_t qh = cmp(a + m, b, bn) >= 0;
+    if (qh) {
+        sub_in_place(a + m, bn, b, bn);
+    }
+
+    const double_limb_t b1 = b[bn - 1], b2 = b[bn - 2];
+    for (size_t j = m; j-- > 0;) {
+        // Estimate the quotient digit by the high limbs, it is at most one too large after the loop
+        const double_limb_t divisible = mult_by_pow_of_2(a[j + bn], BASE_POW) + a[j + bn - 1];
+        double_limb_t possible_q = divisible / b1, possible_r = divisible % b1;
+        while (possible_q >= base ||
+               possible_q * b2 > mult_by_pow_of_2(possible_r, BASE_POW) + a[j + bn - 2]) {
+            --possible_q;
+            possible_r += b1;
+            if (possible_r >= base) {
+                break;
+            }
+        }
+
+        const limb_t borrow = submul_1(a + j, b, bn, possible_q);
+        const limb_t high = a[j + bn];
+        a[j + bn] = high - borrow;
+        if (borrow > high) {
+            // possible_q was one too large, add the divisor back
+            --possible_q;
+            a[j + bn] += add_n(a + j, a + j, b, bn);
+        }
+        q[j] = possible_q;
+    }
+    return qh;
+}
+
+//--------------------------------
+// Recursive division
+//--------------------------------
+// (Brent, Zimmermann "Modern Computer Arithmetic", Algorithm 1.8, after Burnikel and Ziegler)
+
+// t[0, qn + bn + 1) = (q[0, qn) + qh * B^qn) * b[0, bn)
+static void mul_quotient(limb_t *t, const limb_t *q, size_t qn, limb_t qh, const limb_t *b, size_t bn) {
+    mul(t, q, qn, b, bn);
+    t[qn + bn] = qh ? add_in_place(t + qn, bn, b, bn) : 0;
+}
+
+// a[0, n) -= t[0, tn), tn <= n + 1. While the result is negative,
+// adds b[0, n) back and decrements the quotient q[0, qn) with its high limb qh.
+static void sub_and_correct(limb_t *a, size_t n, const limb_t *t, size_t tn, const limb_t *b,
+                            limb_t *q, size_t qn, limb_t &qh) {
+    limb_t borrow = sub_in_place(a, n, t, min(tn, n)) + (tn > n ? t[n] : 0);
+    while (borrow != 0) {
+        const limb_t one = 1;
+        qh -= sub_in_place(q, qn, &one, 1);
+        borrow -= add_n(a, a, b, n);
+    }
+}
+
+// Requires m <= n and the high bit of b[n - 1] set.
+// q[0, m) = a[0, n + m) / b[0, n), returns the high limb of the quotient (0 or 1), a[0, n) = a % b.
+static limb_t divrem_recursive(limb_t *q, limb_t *a, size_t m, const limb_t *b, size_t n) {
+    if (m < max(div_thresholds.burnikel_ziegler, min_recursive_size)) {
+        return divrem_basecase(q, a, n + m, b, n);
+    }
+    if (m < n) {
+        // The quotient is found by the high m limbs of b, the low ones are only a correction
+        const size_t k = n - m;
+        ScratchFrame frame;
+        limb_t *tmp = frame.alloc(n + 1);
+        limb_t qh = divrem_recursive(q, a + k, m, b + k, m);
+        mul_quotient(tmp, q, m, qh, b, k);
+        sub_and_correct(a, n, tmp, n + 1, b, q, m, qh);
+        return qh;
+    }
+
+    // b = b1 * B^k + b0
+    const size_t k = m / 2;
+    const limb_t *b1 = b + k;
+    ScratchFrame frame;
+    limb_t *tmp = frame.alloc(m + 1);
+
+    // q1 = a[2k, n + m) / b1, then a[0, n + k) -= q1 * b0 * B^k
+    limb_t qh = divrem_recursive(q + k, a + 2 * k, m - k, b1, n - k);
+    mul_quotient(tmp, q + k, m - k, qh, b, k);
+    sub_and_correct(a + k, n, tmp, m + 1, b, q + k, m - k, qh);
+
+    // q0 = a[k, n + k) / b1, then a[0, n) -= q0 * b0
+    const limb_t q0h = divrem_recursive(q, a + k, k, b1, n - k);
+    if (q0h) {
+        qh += add_in_place(q + k, m - k, &q0h, 1);
+    }
+    mul_quotient(tmp, q, k, q0h, b, k);
+    sub_and_correct(a, n, tmp, 2 * k + 1, b, q, m, qh);
+
+    return qh;
+}
+
+// Requires an >= bn >= 2 and the high bit of b[bn - 1] set.
+// q[0, an - bn) = a / b, returns the high limb of the quotient (0 or 1), a[0, bn) = a % b.
+static limb_t divrem_normalized(limb_t *q, limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t qn = an - bn;
+    const size_t threshold = max(div_thresholds.burnikel_ziegler, min_recursive_size);
+    if (bn < threshold || qn < threshold) {
+        return divrem_basecase(q, a, an, b, bn);
+    }
+
+    const limb_t qh = cmp(a + qn, b, bn) >= 0;
+    if (qh) {
+        sub_in_place(a + qn, bn, b, bn);
+    }
+
+    // The quotient is computed by blocks of at most bn limbs starting from the high ones.
+    // The high bn limbs of the current part of a are less than b, so every block fits in its limbs.
+    while (qn > 0) {
+        const size_t m = qn % bn == 0 ? bn : qn % bn;
+        qn -= m;
+        divrem_recursive(q + qn, a + qn, m, b, bn);
+    }
+    return qh;
+}
+
+//--------------------------------
+// Dispatcher
+//--------------------------------
+void divrem(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    if (bn == 1) {
+        const limb_t remainder = divrem_1(q, a, an, b[0]);
+        if (r) {
+            r[0] = remainder;
+        }
+        return;
+    }
+
+    // Shift both numbers so that the high bit of the divisor is set, the remainder is shifted back.
+    // a gets an extra limb, so the high limb of the quotient is always zero.
+    const unsigned shift = std::countl_zero(b[bn - 1]);
+    ScratchFrame frame;
+    limb_t *na = frame.alloc(an + 1 + bn), *nb = na + an + 1;
+    lshift(nb, b, bn, shift);
+    na[an] = lshift(na, a, an, shift);
+
+    divrem_normalized(q, na, an + 1, nb, bn);
+    if (r) {
+        rshift(r, na, bn, shift);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "helpers.h"
+
+//--------------------------------
+// Division thresholds
+//--------------------------------
+// Quotient and divisor sizes (in limbs) starting from which the next algorithm is used.
+// Defaults are tuned for x86-64, they can be changed at runtime for a particular machine.
+struct DivThresholds {
+    size_t burnikel_ziegler = 60;
+    // division by a Newton's reciprocal (see reciprocal.h) for quotients longer than 4 divisors
+    size_t barrett = 20000;
+};
+
+extern DivThresholds div_thresholds;
+
+//--------------------------------
+// Division kernels
+//--------------------------------
+// q[0, an - bn + 1) = a[0, an) / b[0, bn), r[0, bn) = a % b.
+// Requires an >= bn >= 1 and b[bn - 1] != 0. a and b are not modified, r can be nullptr.
+// q and r must not overlap with a, b or each other.
+void divrem(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
@@ -3,6 +3,28 @@
 #include <cstdint>
 #include <stdexcept>
 #include <limits>
+#include <bit>
+#include <cstddef>
+
+// Limbs are 32-bit by default. BIGINTEGER_LIMB_BITS=64 selects 64-bit limbs,
+// products and carries of which are computed in unsigned __int128.
+#ifndef BIGINTEGER_LIMB_BITS
+#define BIGINTEGER_LIMB_BITS 32
+#endif
+
+#if BIGINTEGER_LIMB_BITS == 64
+using limb_t = uint64_t;
+using signed_limb_t = int64_t;
+using double_limb_t = unsigned __int128;
+#define BASE_POW 64
+#elif BIGINTEGER_LIMB_BITS == 32
+using limb_t = uint32_t;
+using signed_limb_t = int32_t;
+using double_limb_t = uint64_t;
+#define BASE_POW 32
+#else
+#error "BIGINTEGER_LIMB_BITS must be 32 or 64"
+#endif
 
 template<typename T>
 inline T abs(T num) {
@@ -42,21 +64,97 @@ inline T min(T a, T b) {
     return a > b ? b : a;
 }
 
-inline uint64_t div_by_pow_of_2(uint64_t num, int pow) {
+inline double_limb_t div_by_pow_of_2(double_limb_t num, int pow) {
     return num >> pow;
 }
 
-inline uint64_t mult_by_pow_of_2(uint64_t num, int pow) {
+inline double_limb_t mult_by_pow_of_2(double_limb_t num, int pow) {
     return num << pow;
 }
 
-inline uint64_t mod_by_pow_of_2(uint64_t num, int pow) {
+inline double_limb_t mod_by_pow_of_2(double_limb_t num, int pow) {
     return num & (mult_by_pow_of_2(1, pow) - 1);
 }
 
-uint64_t parse_n_char_str_to_unsigned_int(const char *s, int n);
+// Digits of radixes up to 36 are 0-9 and a-z (A-Z when parsed), radix 64 uses the base64 alphabet A-Z, a-z, 0-9, +, /.
+// Returns the value of the digit c, or -1 if c isn't a digit of the radix.
+inline int digit_value(char c, int radix) {
+    if (radix == 64) {
+        if ('A' <= c && c <= 'Z') {
+            return c - 'A';
+        } else if ('a' <= c && c <= 'z') {
+            return c - 'a' + 26;
+        } else if ('0' <= c && c <= '9') {
+            return c - '0' + 52;
+        }
+        return c == '+' ? 62 : c == '/' ? 63 : -1;
+    }
+    int value = -1;
+    if ('0' <= c && c <= '9') {
+        value = c - '0';
+    } else if ('a' <= c && c <= 'z') {
+        value = c - 'a' + 10;
+    } else if ('A' <= c && c <= 'Z') {
+        value = c - 'A' + 10;
+    }
+    return value < radix ? value : -1;
+}
+
+// The digit with the value v < radix
+inline char digit_char(unsigned v, int radix) {
+    if (radix == 64) {
+        return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[v];
+    }
+    return (char) (v < 10 ? '0' + v : 'a' + v - 10);
+}
+
+inline bool is_power_of_two_radix(int radix) {
+    return 2 <= radix && radix <= 64 && std::has_single_bit((unsigned) radix);
+}
 
 template<typename T>
 inline T div_with_rounding_up(T divisible, T divider) {
     return (divisible + divider - 1) / divider;
-}
\ No newline at end of file
+}
+
+// Window size for the sliding-window exponentiation by an exponent of the given bit length
+inline size_t exponent_window_size(size_t bits) {
+    return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+}
+
+// Scans the exponent e[0, n) from its highest set bit by windows of at most window_size bits
+// that end with a set bit. Calls square() for every bit after the first window
+// and multiply(i) for every window with the value 2i + 1.
+template<typename Square, typename Multiply>
+void scan_exponent_windows(const limb_t *e, size_t n, size_t window_size, Square square, Multiply multiply) {
+    while (n > 0 && e[n - 1] == 0) {
+        --n;
+    }
+    if (n == 0) {
+        return;
+    }
+    auto bit = [e](size_t i) { return div_by_pow_of_2(e[i / BASE_POW], i % BASE_POW) & 1; };
+
+    bool is_started = false;
+    for (size_t i = n * BASE_POW - std::countl_zero(e[n - 1]); i-- > 0;) {
+        if (!bit(i)) {
+            square();
+            continue;
+        }
+        // The window [low, i] is the longest one that ends with a set bit
+        size_t low = i + 1 >= window_size ? i + 1 - window_size : 0;
+        while (!bit(low)) {
+            ++low;
+        }
+        uint32_t value = 0;
+        for (size_t j = i + 1; j-- > low;) {
+            if (is_started) {
+                square();
+            }
+            value = value * 2 + bit(j);
+        }
+        multiply(value / 2);
+        is_started = true;
+        i = low;
+    }
+}
@@ -0,0 +1,265 @@
+#include <bit>
+#include "limbs.h"
+#include "limbs_x86.h"
+#include "helpers.h"
+
+#ifdef BIGINTEGER_X86_KERNELS
+// Checked once at startup, until then (and on older CPUs) the portable loops are used
+static const bool use_x86_kernels = cpu_has_bmi2_adx();
+#endif
+
+#ifdef BIGINTEGER_X86_SIMD
+static const size_t vector_limbs = cpu_vector_bytes() / sizeof(limb_t);
+
+static const bool use_popcnt = cpu_has_popcnt();
+#endif
+
+void copy_limbs(limb_t *r, const limb_t *a, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = a[i];
+    }
+}
+
+void zero_limbs(limb_t *r, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = 0;
+    }
+}
+
+int cmp(const limb_t *a, const limb_t *b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+//--------------------------------
+// Addition and subtraction
+//--------------------------------
+limb_t add_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    double_limb_t carry = 0;
+    size_t i = 0;
+#ifdef BIGINTEGER_X86_KERNELS
+    if (use_x86_kernels && n >= x86_block) {
+        i = n - n % x86_block;
+        carry = add_n_x86(r, a, b, i);
+    }
+#endif
+    for (; i < n; ++i) {
+        double_limb_t digit = (double_limb_t) a[i] + b[i] + carry;
+        r[i] = mod_by_pow_of_2(digit, BASE_POW);
+        carry = div_by_pow_of_2(digit, BASE_POW);
+    }
+    return carry;
+}
+
+limb_t sub_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t digit = a[i] - b[i] - borrow;
+        borrow = (double_limb_t) b[i] + borrow > a[i];
+        r[i] = digit;
+    }
+    return borrow;
+}
+
+limb_t add_in_place(limb_t *r, size_t rn, const limb_t *a, size_t an) {
+    limb_t carry = add_n(r, r, a, an);
+    for (size_t i = an; carry != 0 && i < rn; ++i) {
+        carry = ++r[i] == 0;
+    }
+    return carry;
+}
+
+limb_t sub_in_place(limb_t *r, size_t rn, const limb_t *a, size_t an) {
+    limb_t borrow = sub_n(r, r, a, an);
+    for (size_t i = an; borrow != 0 && i < rn; ++i) {
+        borrow = r[i]-- == 0;
+    }
+    return borrow;
+}
+
+//--------------------------------
+// Multiplication by a limb
+//--------------------------------
+limb_t mul_1(limb_t *r, const limb_t *a, size_t n, limb_t d) {
+    double_limb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double_limb_t digit = (double_limb_t) a[i] * d + carry;
+        r[i] = mod_by_pow_of_2(digit, BASE_POW);
+        carry = div_by_pow_of_2(digit, BASE_POW);
+    }
+    return carry;
+}
+
+limb_t addmul_1(limb_t *r, const limb_t *a, size_t n, limb_t d) {
+    double_limb_t carry = 0;
+    size_t i = 0;
+#ifdef BIGINTEGER_X86_KERNELS
+    if (use_x86_kernels && n >= x86_block) {
+        i = n - n % x86_block;
+        carry = addmul_1_x86(r, a, i, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        double_limb_t digit = (double_limb_t) a[i] * d + r[i] + carry;
+        r[i] = mod_by_pow_of_2(digit, BASE_POW);
+        carry = div_by_pow_of_2(digit, BASE_POW);
+    }
+    return carry;
+}
+
+limb_t submul_1(limb_t *r, const limb_t *a, size_t n, limb_t d) {
+    double_limb_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double_limb_t product = (double_limb_t) a[i] * d + borrow;
+        limb_t low = mod_by_pow_of_2(product, BASE_POW);
+        borrow = div_by_pow_of_2(product, BASE_POW) + (low > r[i]);
+        r[i] -= low;
+    }
+    return borrow;
+}
+
+//--------------------------------
+// Shifts
+//--------------------------------
+limb_t lshift(limb_t *r, const limb_t *a, size_t n, unsigned s) {
+    // From the high limb, so that r may lie above a
+    const limb_t high = div_by_pow_of_2(mult_by_pow_of_2(a[n - 1], s), BASE_POW);
+    for (size_t i = n - 1; i > 0; --i) {
+        double_limb_t digit = mult_by_pow_of_2(a[i], BASE_POW) | a[i - 1];
+        r[i] = mod_by_pow_of_2(div_by_pow_of_2(digit, BASE_POW - s), BASE_POW);
+    }
+    r[0] = mod_by_pow_of_2(mult_by_pow_of_2(a[0], s), BASE_POW);
+    return high;
+}
+
+limb_t rshift(limb_t *r, const limb_t *a, size_t n, unsigned s) {
+    const limb_t low = mod_by_pow_of_2(a[0], s);
+    for (size_t i = 0; i < n; ++i) {
+        double_limb_t digit = a[i] | (i + 1 < n ? mult_by_pow_of_2(a[i + 1], BASE_POW) : 0);
+        r[i] = mod_by_pow_of_2(div_by_pow_of_2(digit, s), BASE_POW);
+    }
+    return low;
+}
+
+//--------------------------------
+// Bitwise operations
+//--------------------------------
+size_t popcount_n(const limb_t *a, size_t n) {
+#ifdef BIGINTEGER_X86_SIMD
+    if (use_popcnt) {
+        return popcount_n_x86(a, n);
+    }
+#endif
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += std::popcount(a[i]);
+    }
+    return count;
+}
+
+// r[0, n) = ((a[0, n) ^ ma) & (b[0, n) ^ mb)) ^ mr, the masks are 0 or all ones
+static void and_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t ma, limb_t mb, limb_t mr) {
+    size_t i = 0;
+#ifdef BIGINTEGER_X86_SIMD
+    if (vector_limbs != 0 && n >= vector_limbs) {
+        i = n - n % vector_limbs;
+        (vector_limbs * sizeof(limb_t) == 64 ? and_n_avx512 : and_n_avx2)(r, a, b, i, ma, mb, mr);
+    }
+#endif
+    for (; i < n; ++i) {
+        r[i] = ((a[i] ^ ma) & (b[i] ^ mb)) ^ mr;
+    }
+}
+
+// r[0, n) = a[0, n) ^ b[0, n) ^ m
+static void xor_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t m) {
+    size_t i = 0;
+#ifdef BIGINTEGER_X86_SIMD
+    if (vector_limbs != 0 && n >= vector_limbs) {
+        i = n - n % vector_limbs;
+        (vector_limbs * sizeof(limb_t) == 64 ? xor_n_avx512 : xor_n_avx2)(r, a, b, i, m);
+    }
+#endif
+    for (; i < n; ++i) {
+        r[i] = a[i] ^ b[i] ^ m;
+    }
+}
+
+static limb_t apply_bitwise(limb_t x, limb_t y, char op) {
+    return op == '&' ? x & y : op == '|' ? x | y : x ^ y;
+}
+
+bool bitwise_signed(limb_t *r, const limb_t *a, size_t an, bool a_negative,
+                    const limb_t *b, size_t bn, bool b_negative, char op) {
+    const bool r_negative = op == '&' ? a_negative && b_negative
+                          : op == '|' ? a_negative || b_negative
+                          : a_negative != b_negative;
+    limb_t ma = a_negative ? ~(limb_t) 0 : 0;
+    limb_t mb = b_negative ? ~(limb_t) 0 : 0;
+    limb_t mr = r_negative ? ~(limb_t) 0 : 0;
+
+    // The two's complement of a magnitude is (a ^ ma) + 1, and the magnitude of a negative result is (t ^ mr) + 1.
+    // The +1 carries only run through the lowest zero limbs, so they are handled limb by limb until all are absorbed.
+    limb_t a_carry = a_negative, b_carry = b_negative, r_carry = r_negative;
+    size_t i = 0;
+    for (; i < an && (a_carry | b_carry | r_carry); ++i) {
+        const limb_t x = (a[i] ^ ma) + a_carry;
+        a_carry &= a[i] == 0;
+        limb_t y = mb;
+        if (i < bn) {
+            y = (b[i] ^ mb) + b_carry;
+            b_carry &= b[i] == 0;
+        }
+        const limb_t t = apply_bitwise(x, y, op);
+        r[i] = (t ^ mr) + r_carry;
+        r_carry &= t == 0;
+    }
+    // The result is -B^an when all its two's complement limbs are zero
+    r[an] = r_carry;
+
+    // Above the carries the forms are just the masked limbs, b is extended by mb.
+    if (op == '^') {
+        const limb_t m = ma ^ mb ^ mr;
+        if (i < bn) {
+            xor_n(r + i, a + i, b + i, bn - i, m);
+            i = bn;
+        }
+        // (a ^ m) & (a ^ m) = a ^ m
+        and_n(r + i, a + i, a + i, an - i, m, m, 0);
+    } else {
+        if (op == '|') {
+            // x | y = ~(~x & ~y)
+            ma = ~ma;
+            mb = ~mb;
+            mr = ~mr;
+        }
+        if (i < bn) {
+            and_n(r + i, a + i, b + i, bn - i, ma, mb, mr);
+            i = bn;
+        }
+        if (mb == 0) {
+            // The extension of b clears the rest, mr is 0 here as well
+            zero_limbs(r + i, an - i);
+        } else {
+            and_n(r + i, a + i, a + i, an - i, ma ^ mr, ma ^ mr, 0);
+        }
+    }
+    return r_negative;
+}
+
+//--------------------------------
+// Division by a limb
+//--------------------------------
+limb_t divrem_1(limb_t *q, const limb_t *a, size_t n, limb_t d) {
+    double_limb_t carry = 0;
+    for (size_t i = n; i-- > 0;) {
+        double_limb_t digit = mult_by_pow_of_2(carry, BASE_POW) + a[i];
+        q[i] = digit / d;
+        carry = digit % d;
+    }
+    return carry;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "helpers.h"
+
+//--------------------------------
+// Limb span kernels
+//--------------------------------
+// Low-level operations on numbers stored as spans of limbs from the least significant one (like mpn in GMP).
+// They work on any caller-owned buffers, sizes are in limbs and must be positive unless stated otherwise.
+// The result r may coincide with the operand a (and b for add_n and sub_n), but must not partially overlap them.
+
+void copy_limbs(limb_t *r, const limb_t *a, size_t n);
+
+void zero_limbs(limb_t *r, size_t n);
+
+// Compares a[0, n) and b[0, n), returns -1, 0 or 1
+int cmp(const limb_t *a, const limb_t *b, size_t n);
+
+// r[0, n) = a[0, n) + b[0, n), returns the carry
+limb_t add_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+// r[0, n) = a[0, n) - b[0, n), returns the borrow
+limb_t sub_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+// r[0, rn) += a[0, an), rn >= an. Stops as soon as the carry is absorbed, returns the carry out of r.
+limb_t add_in_place(limb_t *r, size_t rn, const limb_t *a, size_t an);
+
+// r[0, rn) -= a[0, an), rn >= an. Stops as soon as the borrow is absorbed, returns the borrow out of r.
+limb_t sub_in_place(limb_t *r, size_t rn, const limb_t *a, size_t an);
+
+// r[0, n) = a[0, n) * d, returns the high limb
+limb_t mul_1(limb_t *r, const limb_t *a, size_t n, limb_t d);
+
+// r[0, n) += a[0, n) * d, returns the high limb
+limb_t addmul_1(limb_t *r, const limb_t *a, size_t n, limb_t d);
+
+// r[0, n) -= a[0, n) * d, returns the high limb of the borrow
+limb_t submul_1(limb_t *r, const limb_t *a, size_t n, limb_t d);
+
+// r[0, n) = a[0, n) << s, 0 <= s < BASE_POW. Returns the bits shifted out. r may also lie above a.
+limb_t lshift(limb_t *r, const limb_t *a, size_t n, unsigned s);
+
+// r[0, n) = a[0, n) >> s, 0 <= s < BASE_POW. Returns the bits shifted out. r may also lie below a.
+limb_t rshift(limb_t *r, const limb_t *a, size_t n, unsigned s);
+
+// Returns the number of set bits in a[0, n)
+size_t popcount_n(const limb_t *a, size_t n);
+
+// Bitwise operation op ('&', '|' or '^') on the infinite two's complement forms of the numbers with
+// magnitudes a[0, an) and b[0, bn), an >= bn. Writes the magnitude of the result to r[0, an + 1),
+// returns true if the result is negative. Negative zero is not allowed.
+bool bitwise_signed(limb_t *r, const limb_t *a, size_t an, bool a_negative,
+                    const limb_t *b, size_t bn, bool b_negative, char op);
+
+// q[0, n) = a[0, n) / d, returns the remainder
+limb_t divrem_1(limb_t *q, const limb_t *a, size_t n, limb_t d);
@@ -0,0 +1,160 @@
+#include "limbs_x86.h"
+
+#ifdef BIGINTEGER_X86_SIMD
+#include <immintrin.h>
+
+size_t cpu_vector_bytes() {
+    // This runs during static initialization, before the CPU model is filled in by the runtime
+    __builtin_cpu_init();
+    // Unlike raw cpuid, these also check that the OS saves the vector registers
+    if (__builtin_cpu_supports("avx512f")) {
+        return 64;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return 32;
+    }
+    return 0;
+}
+
+bool cpu_has_popcnt() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("popcnt");
+}
+
+__attribute__((target("popcnt")))
+size_t popcount_n_x86(const limb_t *a, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += __builtin_popcountll(a[i]);
+    }
+    return count;
+}
+
+//--------------------------------
+// AVX2
+//--------------------------------
+__attribute__((target("avx2")))
+void and_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t ma, limb_t mb, limb_t mr) {
+    const __m256i va = _mm256_set1_epi8((char) ma), vb = _mm256_set1_epi8((char) mb), vr = _mm256_set1_epi8((char) mr);
+    for (size_t i = 0; i < n * sizeof(limb_t); i += 32) {
+        const __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) ((const char *) a + i)), va);
+        const __m256i y = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) ((const char *) b + i)), vb);
+        _mm256_storeu_si256((__m256i *) ((char *) r + i), _mm256_xor_si256(_mm256_and_si256(x, y), vr));
+    }
+}
+
+__attribute__((target("avx2")))
+void xor_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t m) {
+    const __m256i vm = _mm256_set1_epi8((char) m);
+    for (size_t i = 0; i < n * sizeof(limb_t); i += 32) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) ((const char *) a + i));
+        const __m256i y = _mm256_loadu_si256((const __m256i *) ((const char *) b + i));
+        _mm256_storeu_si256((__m256i *) ((char *) r + i), _mm256_xor_si256(_mm256_xor_si256(x, y), vm));
+    }
+}
+
+//--------------------------------
+// AVX-512
+//--------------------------------
+__attribute__((target("avx512f")))
+void and_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t ma, limb_t mb, limb_t mr) {
+    const __m512i va = _mm512_set1_epi32((int) ma), vb = _mm512_set1_epi32((int) mb), vr = _mm512_set1_epi32((int) mr);
+    for (size_t i = 0; i < n * sizeof(limb_t); i += 64) {
+        const __m512i x = _mm512_xor_si512(_mm512_loadu_si512((const char *) a + i), va);
+        const __m512i y = _mm512_xor_si512(_mm512_loadu_si512((const char *) b + i), vb);
+        _mm512_storeu_si512((char *) r + i, _mm512_xor_si512(_mm512_and_si512(x, y), vr));
+    }
+}
+
+__attribute__((target("avx512f")))
+void xor_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t m) {
+    const __m512i vm = _mm512_set1_epi32((int) m);
+    for (size_t i = 0; i < n * sizeof(limb_t); i += 64) {
+        const __m512i x = _mm512_loadu_si512((const char *) a + i);
+        const __m512i y = _mm512_loadu_si512((const char *) b + i);
+        // 0x96 is the truth table of x ^ y ^ m
+        _mm512_storeu_si512((char *) r + i, _mm512_ternarylogic_epi32(x, y, vm, 0x96));
+    }
+}
+#endif
+
+#ifdef BIGINTEGER_X86_KERNELS
+bool cpu_has_bmi2_adx() {
+    // This runs during static initialization, before the CPU model is filled in by the runtime
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+}
+
+limb_t add_n_x86(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    size_t blocks = n / x86_block;
+    limb_t carry, t0, t1;
+    // DEC doesn't change CF, so the carry goes through the whole loop in the flags
+    asm volatile(
+            "xor %k[carry], %k[carry]\n\t"
+            "1:\n\t"
+            "mov (%[a]), %[t0]\n\t"
+            "mov 8(%[a]), %[t1]\n\t"
+            "adc (%[b]), %[t0]\n\t"
+            "adc 8(%[b]), %[t1]\n\t"
+            "mov %[t0], (%[r])\n\t"
+            "mov %[t1], 8(%[r])\n\t"
+            "mov 16(%[a]), %[t0]\n\t"
+            "mov 24(%[a]), %[t1]\n\t"
+            "adc 16(%[b]), %[t0]\n\t"
+            "adc 24(%[b]), %[t1]\n\t"
+            "mov %[t0], 16(%[r])\n\t"
+            "mov %[t1], 24(%[r])\n\t"
+            "lea 32(%[a]), %[a]\n\t"
+            "lea 32(%[b]), %[b]\n\t"
+            "lea 32(%[r]), %[r]\n\t"
+            "dec %[blocks]\n\t"
+            "jnz 1b\n\t"
+            "setc %b[carry]\n\t"
+            : [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), [blocks] "+r"(blocks),
+              [carry] "=&r"(carry), [t0] "=&r"(t0), [t1] "=&r"(t1)
+            :
+            : "cc", "memory");
+    return carry;
+}
+
+limb_t addmul_1_x86(limb_t *r, const limb_t *a, size_t n, limb_t d) {
+    size_t blocks = n / x86_block;
+    limb_t high, lo0, hi0, lo1, hi1;
+    // ADOX adds the high limb of the previous product (OF chain), ADCX adds r[i] (CF chain).
+    // Neither LEA nor JRCXZ touches the flags, so both chains survive the loop control.
+    asm volatile(
+            "xor %k[high], %k[high]\n\t"
+            "1:\n\t"
+            "mulx (%[a]), %[lo0], %[hi0]\n\t"
+            "adox %[high], %[lo0]\n\t"
+            "adcx (%[r]), %[lo0]\n\t"
+            "mov %[lo0], (%[r])\n\t"
+            "mulx 8(%[a]), %[lo1], %[hi1]\n\t"
+            "adox %[hi0], %[lo1]\n\t"
+            "adcx 8(%[r]), %[lo1]\n\t"
+            "mov %[lo1], 8(%[r])\n\t"
+            "mulx 16(%[a]), %[lo0], %[hi0]\n\t"
+            "adox %[hi1], %[lo0]\n\t"
+            "adcx 16(%[r]), %[lo0]\n\t"
+            "mov %[lo0], 16(%[r])\n\t"
+            "mulx 24(%[a]), %[lo1], %[high]\n\t"
+            "adox %[hi0], %[lo1]\n\t"
+            "adcx 24(%[r]), %[lo1]\n\t"
+            "mov %[lo1], 24(%[r])\n\t"
+            "lea 32(%[a]), %[a]\n\t"
+            "lea 32(%[r]), %[r]\n\t"
+            "lea -1(%[blocks]), %[blocks]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            // The carries of both chains go to the high limb, it can't overflow
+            "mov $0, %k[lo0]\n\t"
+            "adox %[lo0], %[high]\n\t"
+            "adcx %[lo0], %[high]\n\t"
+            : [r] "+r"(r), [a] "+r"(a), [blocks] "+c"(blocks), [high] "=&r"(high),
+              [lo0] "=&r"(lo0), [hi0] "=&r"(hi0), [lo1] "=&r"(lo1), [hi1] "=&r"(hi1)
+            : "d"(d)
+            : "cc", "memory");
+    return high;
+}
+#endif
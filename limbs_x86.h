@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "helpers.h"
+
+//--------------------------------
+// x86-64 limb kernels
+//--------------------------------
+// Hand-written versions of the hot kernels for 64-bit limbs. addmul_1 keeps two independent
+// carry chains with MULX, ADCX and ADOX (BMI2 and ADX), so the CPU must be checked before using them.
+// They process whole blocks of x86_block limbs, n must be a positive multiple of it.
+// The vector kernels don't depend on the limb size, they process whole vectors of vector_bytes.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BIGINTEGER_X86_SIMD 1
+
+// Returns the widest usable vector in bytes: 64 with AVX-512, 32 with AVX2, 0 otherwise
+size_t cpu_vector_bytes();
+
+// r[0, n) = ((a[0, n) ^ ma) & (b[0, n) ^ mb)) ^ mr, the masks are 0 or all ones
+void and_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t ma, limb_t mb, limb_t mr);
+
+void and_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t ma, limb_t mb, limb_t mr);
+
+// r[0, n) = a[0, n) ^ b[0, n) ^ m, the mask is 0 or all ones
+void xor_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t m);
+
+void xor_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t m);
+
+bool cpu_has_popcnt();
+
+// Returns the number of set bits in a[0, n) using the POPCNT instruction
+size_t popcount_n_x86(const limb_t *a, size_t n);
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__) && BIGINTEGER_LIMB_BITS == 64
+#define BIGINTEGER_X86_KERNELS 1
+
+static const size_t x86_block = 4;
+
+bool cpu_has_bmi2_adx();
+
+// r[0, n) = a[0, n) + b[0, n), returns the carry
+limb_t add_n_x86(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+// r[0, n) += a[0, n) * d, returns the high limb
+limb_t addmul_1_x86(limb_t *r, const limb_t *a, size_t n, limb_t d);
+#endif
@@ -0,0 +1,152 @@
+#include "montgomery.h"
+#include "limbs.h"
+
+// -m^(-1) mod B for odd m. m is its own inverse mod 8, every Newton step doubles the correct bits.
+static limb_t negative_inverse(limb_t m) {
+    limb_t inverse = m;
+    for (int bits = 3; bits < BASE_POW; bits *= 2) {
+        inverse *= 2 - m * inverse;
+    }
+    return -inverse;
+}
+
+// Copies a[0, an) into r[0, n) padded with zeros, an <= n
+static void copy_padded(limb_t *r, const limb_t *a, size_t an, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = i < an ? a[i] : 0;
+    }
+}
+
+MontgomeryContext::MontgomeryContext(const BigInteger &modulus) : m_modulus(modulus) {
+    if (modulus <= 0 || !is_odd(modulus.m_digits[0])) {
+        throw std::invalid_argument("Montgomery modulus must be positive and odd.");
+    }
+    m_size = modulus.m_digits.size();
+    m_limbs = Vector<limb_t>(m_size, 0);
+    copy_padded(m_limbs.data(), modulus.m_digits.data(), m_size, m_size);
+    m_inverse = negative_inverse(m_limbs[0]);
+    m_scratch = Vector<limb_t>(2 * m_size + 1, 0);
+
+    const BigInteger r = BigInteger(1) << BASE_POW * m_size;
+    m_one = Vector<limb_t>(m_size, 0);
+    const BigInteger one = r % modulus;
+    copy_padded(m_one.data(), one.m_digits.data(), one.m_digits.size(), m_size);
+    m_r2 = Vector<limb_t>(m_size, 0);
+    const BigInteger r2 = r * r % modulus;
+    copy_padded(m_r2.data(), r2.m_digits.data(), r2.m_digits.size(), m_size);
+}
+
+void MontgomeryContext::to_montgomery(limb_t *r, const BigInteger &a) const {
+    BigInteger reduced = a % m_modulus;
+    if (reduced < 0) {
+        reduced += m_modulus;
+    }
+    copy_padded(r, reduced.m_digits.data(), reduced.m_digits.size(), m_size);
+    mul(r, r, m_r2.data());
+}
+
+BigInteger MontgomeryContext::from_montgomery(const limb_t *a) const {
+    limb_t *t = m_scratch.data();
+    for (size_t i = 0; i < 2 * m_size; ++i) {
+        t[i] = i < m_size ? a[i] : 0;
+    }
+    BigInteger result;
+    result.m_digits = BigInteger::Digits(m_size, 0);
+    reduce(result.m_digits.data());
+    result.remove_high_order_zeros();
+    return result;
+}
+
+void MontgomeryContext::one(limb_t *r) const {
+    for (size_t i = 0; i < m_size; ++i) {
+        r[i] = m_one[i];
+    }
+}
+
+void MontgomeryContext::mul(limb_t *r, const limb_t *a, const limb_t *b) const {
+    // Coarsely integrated operand scanning (CIOS): t = (t + a * b[i] + q * m) / B
+    // with q chosen so that the lowest limb becomes zero
+    const size_t n = m_size;
+    const limb_t *m = m_limbs.data();
+    limb_t *t = m_scratch.data();
+    for (size_t i = 0; i < n + 2; ++i) {
+        t[i] = 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        double_limb_t carry = 0;
+        for (size_t j = 0; j < n; ++j) {
+            double_limb_t digit = (double_limb_t) a[j] * b[i] + t[j] + carry;
+            t[j] = mod_by_pow_of_2(digit, BASE_POW);
+            carry = div_by_pow_of_2(digit, BASE_POW);
+        }
+        double_limb_t digit = t[n] + carry;
+        t[n] = mod_by_pow_of_2(digit, BASE_POW);
+        t[n + 1] = div_by_pow_of_2(digit, BASE_POW);
+
+        const limb_t q = t[0] * m_inverse;
+        carry = div_by_pow_of_2((double_limb_t) q * m[0] + t[0], BASE_POW);
+        for (size_t j = 1; j < n; ++j) {
+            digit = (double_limb_t) q * m[j] + t[j] + carry;
+            t[j - 1] = mod_by_pow_of_2(digit, BASE_POW);
+            carry = div_by_pow_of_2(digit, BASE_POW);
+        }
+        digit = t[n] + carry;
+        t[n - 1] = mod_by_pow_of_2(digit, BASE_POW);
+        t[n] = t[n + 1] + div_by_pow_of_2(digit, BASE_POW);
+    }
+    subtract_modulus(r, t);
+}
+
+void MontgomeryContext::sqr(limb_t *r, const limb_t *a) const {
+    // The square is computed by the squaring kernel, which takes cross products once, and reduced separately
+    ::sqr(m_scratch.data(), a, m_size);
+    reduce(r);
+}
+
+void MontgomeryContext::reduce(limb_t *r) const {
+    const size_t n = m_size;
+    const limb_t *m = m_limbs.data();
+    limb_t *t = m_scratch.data();
+    t[2 * n] = 0;
+
+    // Every step zeroes the lowest remaining limb of t by adding a multiple of m
+    for (size_t i = 0; i < n; ++i) {
+        const limb_t carry = addmul_1(t + i, m, n, t[i] * m_inverse);
+        add_in_place(t + i + n, n + 1 - i, &carry, 1);
+    }
+    subtract_modulus(r, t + n);
+}
+
+void MontgomeryContext::subtract_modulus(limb_t *r, const limb_t *t) const {
+    const size_t n = m_size;
+    if (t[n] != 0 || cmp(t, m_limbs.data(), n) >= 0) {
+        sub_n(r, t, m_limbs.data(), n);
+    } else {
+        copy_limbs(r, t, n);
+    }
+}
+
+BigInteger MontgomeryContext::pow_mod(const BigInteger &base, const BigInteger &exp) const {
+    if (exp < 0) {
+        throw std::invalid_argument("Exponent must be non-negative.");
+    }
+    // Odd powers base^1, base^3, ..., base^(2^window_size - 1) for the sliding window
+    const size_t n = m_size;
+    const size_t window_size = exponent_window_size(exp.m_digits.size() * BASE_POW);
+    const size_t powers_count = mult_by_pow_of_2(1, window_size - 1);
+    Vector<limb_t> powers(powers_count * n, 0), result(n, 0);
+    to_montgomery(powers.data(), base);
+    if (powers_count > 1) {
+        sqr(result.data(), powers.data());
+        for (size_t i = 1; i < powers_count; ++i) {
+            mul(powers.data() + i * n, powers.data() + (i - 1) * n, result.data());
+        }
+    }
+
+    one(result.data());
+    scan_exponent_windows(exp.m_digits.data(), exp.m_digits.size(), window_size,
+                          [&] { sqr(result.data(), result.data()); },
+                          [&](size_t i) { mul(result.data(), result.data(), powers.data() + i * n); });
+    return from_montgomery(result.data());
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "biginteger.h"
+
+//--------------------------------
+// MontgomeryContext
+//--------------------------------
+// Modular arithmetic by a fixed odd modulus m of n limbs. Numbers are kept in Montgomery form
+// a * R mod m, R = B^n, as buffers of exactly n limbs, so a product needs no division.
+// Operations reuse the scratch buffer of the context: they don't allocate memory,
+// but a context must not be used from several threads at once.
+class MontgomeryContext {
+    BigInteger m_modulus;
+    Vector<limb_t> m_limbs;
+    // -m^(-1) mod B
+    limb_t m_inverse;
+    // R mod m (1 in Montgomery form) and R^2 mod m (for conversion into the form)
+    Vector<limb_t> m_one;
+    Vector<limb_t> m_r2;
+    size_t m_size;
+    mutable Vector<limb_t> m_scratch;
+
+public:
+    // throws std::invalid_argument if the modulus is not positive and odd
+    explicit MontgomeryContext(const BigInteger &modulus);
+
+    [[nodiscard]] const BigInteger &modulus() const { return m_modulus; }
+
+    // number of limbs in every buffer
+    [[nodiscard]] size_t size() const { return m_size; }
+
+    // r = a * R mod m
+    void to_montgomery(limb_t *r, const BigInteger &a) const;
+
+    // returns a / R mod m
+    [[nodiscard]] BigInteger from_montgomery(const limb_t *a) const;
+
+    // r = 1 in Montgomery form
+    void one(limb_t *r) const;
+
+    // r = a * b / R mod m, r may be the same buffer as a or b
+    void mul(limb_t *r, const limb_t *a, const limb_t *b) const;
+
+    // r = a^2 / R mod m, r may be the same buffer as a
+    void sqr(limb_t *r, const limb_t *a) const;
+
+    // base^exp mod m in the usual form by the sliding-window method,
+    // throws std::invalid_argument if exp is negative
+    [[nodiscard]] BigInteger pow_mod(const BigInteger &base, const BigInteger &exp) const;
+
+private:
+    // r = m_scratch[0, 2n) / R mod m
+    void reduce(limb_t *r) const;
+
+    // r = t[0, n] mod m, where t < 2m
+    void subtract_modulus(limb_t *r, const limb_t *t) const;
+};
@@ -0,0 +1,617 @@
+#include <utility>
+#include "multiplication.h"
+#include "helpers.h"
+#include "limbs.h"
+#include "scratch.h"
+
+MulThresholds mul_thresholds;
+
+// Karatsuba step needs at least 4 limbs, otherwise (a0 + a1) is as long as a itself
+static const size_t min_karatsuba_size = 4;
+
+// Same for Toom-Cook, evaluated pieces must be shorter than the operands
+static const size_t min_toom_size = 8;
+
+//--------------------------------
+// Helpers
+//--------------------------------
+// r[0, rn) -= a[0, an) * d modulo B^rn, rn >= an
+static void submul_1_mod(limb_t *r, size_t rn, const limb_t *a, size_t an, limb_t d) {
+    const limb_t borrow = submul_1(r, a, an, d);
+    if (borrow != 0 && an < rn) {
+        sub_in_place(r + an, rn - an, &borrow, 1);
+    }
+}
+
+// r[0, n) = -r[0, n) modulo B^n
+static void neg_mod(limb_t *r, size_t n) {
+    size_t i = 0;
+    while (i < n && r[i] == 0) {
+        ++i;
+    }
+    if (i < n) {
+        r[i] = -r[i];
+        for (++i; i < n; ++i) {
+            r[i] = ~r[i];
+        }
+    }
+}
+
+// Arithmetic right shift of a two's complement number r[0, n) by s < BASE_POW bits
+static void rshift_signed(limb_t *r, size_t n, unsigned s) {
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i] = (r[i] >> s) | (limb_t) ((double_limb_t) r[i + 1] << (BASE_POW - s));
+    }
+    r[n - 1] = (limb_t) ((signed_limb_t) r[n - 1] >> s);
+}
+
+// r[0, n) = r[0, n) / d modulo B^n, where d is odd and divides r exactly.
+// Hensel division, works for two's complement numbers as well.
+static void divexact_1_mod(limb_t *r, size_t n, limb_t d) {
+    // d^-1 modulo B by Newton's iteration, d is its own inverse modulo 8 and each step doubles the correct bits
+    limb_t inverse = d;
+    for (int i = 0; i < 5; ++i) {
+        inverse *= 2 - d * inverse;
+    }
+
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t digit = r[i] - borrow;
+        limb_t q = digit * inverse;
+        borrow = div_by_pow_of_2((double_limb_t) q * d, BASE_POW) + (digit > r[i]);
+        r[i] = q;
+    }
+}
+
+//--------------------------------
+// Schoolbook multiplication
+//--------------------------------
+void mul_basecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    zero_limbs(r, an);
+
+    for (size_t j = 0; j < bn; ++j) {
+        r[j + an] = b[j] == 0 ? 0 : addmul_1(r + j, a, an, b[j]);
+    }
+}
+
+// Cross products a[i] * a[j], i < j, are computed once and doubled
+void sqr_basecase(limb_t *r, const limb_t *a, size_t n) {
+    if (n == 0) {
+        return;
+    }
+
+    zero_limbs(r, n);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    r[2 * n - 1] = 0;
+    lshift(r, r, 2 * n, 1);
+
+    double_limb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double_limb_t square = (double_limb_t) a[i] * a[i];
+        double_limb_t digit = (double_limb_t) r[2 * i] + mod_by_pow_of_2(square, BASE_POW) + carry;
+        r[2 * i] = mod_by_pow_of_2(digit, BASE_POW);
+        digit = (double_limb_t) r[2 * i + 1] + div_by_pow_of_2(square, BASE_POW) + div_by_pow_of_2(digit, BASE_POW);
+        r[2 * i + 1] = mod_by_pow_of_2(digit, BASE_POW);
+        carry = div_by_pow_of_2(digit, BASE_POW);
+    }
+}
+
+//--------------------------------
+// Karatsuba multiplication
+//--------------------------------
+// Requires (an + 1) / 2 < bn <= an.
+// a = a1 * B^h + a0, b = b1 * B^h + b0,
+// a * b = z2 * B^2h + (z1 - z2 - z0) * B^h + z0, where
+// z0 = a0 * b0, z2 = a1 * b1, z1 = (a0 + a1) * (b0 + b1)
+static void mul_karatsuba(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    const size_t h = (an + 1) / 2;
+    const size_t a1n = an - h, b1n = bn - h;
+
+    // z0 and z2 are written right into their places in the result
+    mul(r, a, h, b, h);
+    mul(r + 2 * h, a + h, a1n, b + h, b1n);
+
+    ScratchFrame frame;
+    limb_t *sa = frame.alloc(4 * (h + 1)), *sb = sa + h + 1, *z1 = sb + h + 1;
+
+    copy_limbs(sa, a, h);
+    sa[h] = add_in_place(sa, h, a + h, a1n);
+    copy_limbs(sb, b, h);
+    sb[h] = add_in_place(sb, h, b + h, b1n);
+    const size_t san = h + (sa[h] != 0), sbn = h + (sb[h] != 0);
+    mul(z1, sa, san, sb, sbn);
+
+    sub_in_place(z1, san + sbn, r, 2 * h);
+    sub_in_place(z1, san + sbn, r + 2 * h, a1n + b1n);
+
+    // z1 - z2 - z0 = a0 * b1 + a1 * b0 < 2 * B^an, so the high limbs of z1 are zeros now
+    add_in_place(r + h, an + bn - h, z1, min(san + sbn, an + bn - h));
+}
+
+// a = a1 * B^h + a0, 2 * a0 * a1 = a0^2 + a1^2 - (a0 - a1)^2
+static void sqr_karatsuba(limb_t *r, const limb_t *a, size_t n) {
+    const size_t h = (n + 1) / 2;
+    const size_t a1n = n - h;
+
+    sqr(r, a, h);
+    sqr(r + 2 * h, a + h, a1n);
+
+    ScratchFrame frame;
+    limb_t *d = frame.alloc(5 * h + 1), *z1 = d + h, *m = z1 + 2 * h;
+
+    // d = |a0 - a1|
+    copy_limbs(d, a, h);
+    if (sub_in_place(d, h, a + h, a1n)) {
+        neg_mod(d, h);
+    }
+    sqr(z1, d, h);
+
+    copy_limbs(m, r, 2 * h);
+    m[2 * h] = add_in_place(m, 2 * h, r + 2 * h, 2 * a1n);
+    sub_in_place(m, 2 * h + 1, z1, 2 * h);
+    add_in_place(r + h, 2 * n - h, m, min(2 * h + 1, 2 * n - h));
+}
+
+//--------------------------------
+// Toom-Cook multiplication
+//--------------------------------
+// a and b are split into pieces of k limbs and treated as polynomials in x = B^k.
+// The polynomials are evaluated at several points, the values are multiplied recursively
+// and the coefficients of the product polynomial are restored by interpolation.
+// Values at negative points and intermediate results of interpolation can be negative,
+// so they are stored in two's complement form of a fixed width that is enough for all of them.
+namespace {
+    struct Piece {
+        const limb_t *p;
+        size_t n;
+    };
+}
+
+// Splits a[0, an) into count pieces of k limbs, the high pieces can be shorter or empty
+static void split(const limb_t *a, size_t an, size_t k, Piece *pieces, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const size_t begin = min(i * k, an);
+        pieces[i] = {a + begin, min(k, an - begin)};
+    }
+}
+
+// r[0, rn) += sum of pieces[i] * x^i for i = first, first + 2, ...
+static void addmul_pieces(limb_t *r, size_t rn, const Piece *pieces, size_t count, size_t first, limb_t x) {
+    for (size_t i = first; i < count; i += 2) {
+        const limb_t carry = addmul_1(r, pieces[i].p, pieces[i].n, pow(x, i));
+        if (carry != 0 && pieces[i].n < rn) {
+            add_in_place(r + pieces[i].n, rn - pieces[i].n, &carry, 1);
+        }
+    }
+}
+
+// Evaluates the polynomial at x: r[0, k + 1)
+static void eval_at(limb_t *r, size_t k, const Piece *pieces, size_t count, limb_t x) {
+    zero_limbs(r, k + 1);
+    addmul_pieces(r, k + 1, pieces, count, 0, x);
+    addmul_pieces(r, k + 1, pieces, count, 1, x);
+}
+
+// Evaluates the polynomial at x and -x: plus[0, k + 1) and the absolute value minus[0, k + 1).
+// tmp[0, k + 1) is used as a scratch space. Returns true if the value at -x is negative.
+static bool eval_pm(limb_t *plus, limb_t *minus, limb_t *tmp, size_t k,
+                    const Piece *pieces, size_t count, limb_t x) {
+    // even and odd parts
+    zero_limbs(plus, k + 1);
+    zero_limbs(tmp, k + 1);
+    addmul_pieces(plus, k + 1, pieces, count, 0, x);
+    addmul_pieces(tmp, k + 1, pieces, count, 1, x);
+
+    const bool negative = cmp(plus, tmp, k + 1) < 0;
+    if (negative) {
+        sub_n(minus, tmp, plus, k + 1);
+    } else {
+        sub_n(minus, plus, tmp, k + 1);
+    }
+    add_in_place(plus, k + 1, tmp, k + 1);
+    return negative;
+}
+
+// r[0, rn) = x[0, n) * y[0, n) in two's complement form, negated if negative is true
+static void mul_signed(limb_t *r, size_t rn, const limb_t *x, const limb_t *y, size_t n, bool negative) {
+    size_t xn = n, yn = n;
+    while (xn > 0 && x[xn - 1] == 0) --xn;
+    while (yn > 0 && y[yn - 1] == 0) --yn;
+
+    mul(r, x, xn, y, yn);
+    zero_limbs(r + xn + yn, rn - xn - yn);
+    if (negative) {
+        neg_mod(r, rn);
+    }
+}
+
+// r[0, rn) += c[0, cn) * B^offset, the part of c that doesn't fit in r must be zero
+static void add_shifted(limb_t *r, size_t rn, size_t offset, const limb_t *c, size_t cn) {
+    if (offset < rn) {
+        add_in_place(r + offset, rn - offset, c, min(cn, rn - offset));
+    }
+}
+
+// Requires (an + 1) / 2 < bn <= an. Evaluates at 0, 1, -1, 2 and infinity.
+static void mul_toom3(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    const size_t k = div_with_rounding_up(an, (size_t) 3);
+    const size_t n = k + 1, L = 2 * n;
+    Piece pa[3], pb[3];
+    split(a, an, k, pa, 3);
+    split(b, bn, k, pb, 3);
+
+    ScratchFrame frame;
+    limb_t *a1 = frame.alloc(7 * n + 4 * L), *am1 = a1 + n, *a2 = am1 + n;
+    limb_t *b1 = a2 + n, *bm1 = b1 + n, *b2 = bm1 + n, *t = b2 + n;
+    limb_t *v1 = t + n, *vm1 = v1 + L, *v2 = vm1 + L, *vinf = v2 + L;
+
+    // Evaluation and pointwise multiplication, v0 is placed right into r[0, 2k).
+    // When squaring, b is not evaluated, so the recursive calls get the same operands and square them.
+    bool negative = eval_pm(a1, am1, t, k, pa, 3, 1);
+    eval_at(a2, k, pa, 3, 2);
+    if (a == b && an == bn) {
+        b1 = a1, bm1 = am1, b2 = a2;
+        negative = false;
+    } else {
+        negative = negative != eval_pm(b1, bm1, t, k, pb, 3, 1);
+        eval_at(b2, k, pb, 3, 2);
+    }
+    mul_signed(v1, L, a1, b1, n, false);
+    mul_signed(vm1, L, am1, bm1, n, negative);
+    mul_signed(v2, L, a2, b2, n, false);
+    mul(vinf, pa[2].p, pa[2].n, pb[2].p, pb[2].n);
+    zero_limbs(vinf + pa[2].n + pb[2].n, L - pa[2].n - pb[2].n);
+    mul(r, pa[0].p, k, pb[0].p, k);
+    const limb_t *v0 = r;
+
+    // Interpolation
+    sub_n(vm1, v1, vm1, L);
+    rshift_signed(vm1, L, 1);               // c1 + c3
+    sub_n(v1, v1, vm1, L);
+    sub_in_place(v1, L, v0, 2 * k);
+    sub_in_place(v1, L, vinf, L);           // c2
+    sub_in_place(v2, L, v0, 2 * k);
+    submul_1_mod(v2, L, v1, L, 4);
+    submul_1_mod(v2, L, vinf, L, 16);
+    rshift_signed(v2, L, 1);                // c1 + 4 * c3
+    sub_n(v2, v2, vm1, L);
+    divexact_1_mod(v2, L, 3);               // c3
+    sub_n(vm1, vm1, v2, L);                 // c1
+
+    // Recomposition
+    const size_t rn = an + bn;
+    zero_limbs(r + 2 * k, rn - 2 * k);
+    add_shifted(r, rn, k, vm1, L);
+    add_shifted(r, rn, 2 * k, v1, L);
+    add_shifted(r, rn, 3 * k, v2, L);
+    add_shifted(r, rn, 4 * k, vinf, L);
+}
+
+// Requires (an + 1) / 2 < bn <= an. Evaluates at 0, 1, -1, 2, -2, 3 and infinity.
+static void mul_toom4(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    const size_t k = div_with_rounding_up(an, (size_t) 4);
+    const size_t n = k + 1, L = 2 * n;
+    Piece pa[4], pb[4];
+    split(a, an, k, pa, 4);
+    split(b, bn, k, pb, 4);
+
+    ScratchFrame frame;
+    limb_t *a1 = frame.alloc(11 * n + 6 * L), *am1 = a1 + n, *a2 = am1 + n, *am2 = a2 + n, *a3 = am2 + n;
+    limb_t *b1 = a3 + n, *bm1 = b1 + n, *b2 = bm1 + n, *bm2 = b2 + n, *b3 = bm2 + n, *t = b3 + n;
+    limb_t *v1 = t + n, *vm1 = v1 + L, *v2 = vm1 + L, *vm2 = v2 + L, *v3 = vm2 + L, *vinf = v3 + L;
+
+    // Evaluation and pointwise multiplication, v0 is placed right into r[0, 2k).
+    // When squaring, b is not evaluated, so the recursive calls get the same operands and square them.
+    bool negative1 = eval_pm(a1, am1, t, k, pa, 4, 1);
+    bool negative2 = eval_pm(a2, am2, t, k, pa, 4, 2);
+    eval_at(a3, k, pa, 4, 3);
+    if (a == b && an == bn) {
+        b1 = a1, bm1 = am1, b2 = a2, bm2 = am2, b3 = a3;
+        negative1 = negative2 = false;
+    } else {
+        negative1 = negative1 != eval_pm(b1, bm1, t, k, pb, 4, 1);
+        negative2 = negative2 != eval_pm(b2, bm2, t, k, pb, 4, 2);
+        eval_at(b3, k, pb, 4, 3);
+    }
+    mul_signed(v1, L, a1, b1, n, false);
+    mul_signed(vm1, L, am1, bm1, n, negative1);
+    mul_signed(v2, L, a2, b2, n, false);
+    mul_signed(vm2, L, am2, bm2, n, negative2);
+    mul_signed(v3, L, a3, b3, n, false);
+    mul(vinf, pa[3].p, pa[3].n, pb[3].p, pb[3].n);
+    zero_limbs(vinf + pa[3].n + pb[3].n, L - pa[3].n - pb[3].n);
+    mul(r, pa[0].p, k, pb[0].p, k);
+    const limb_t *v0 = r;
+
+    // Interpolation
+    sub_n(vm1, v1, vm1, L);
+    rshift_signed(vm1, L, 1);               // c1 + c3 + c5
+    sub_n(v1, v1, vm1, L);                  // c0 + c2 + c4 + c6
+    sub_n(vm2, v2, vm2, L);
+    rshift_signed(vm2, L, 2);               // c1 + 4 * c3 + 16 * c5
+    submul_1_mod(v2, L, vm2, L, 2);         // c0 + 4 * c2 + 16 * c4 + 64 * c6
+    sub_in_place(v1, L, v0, 2 * k);
+    sub_in_place(v1, L, vinf, L);           // c2 + c4
+    sub_in_place(v2, L, v0, 2 * k);
+    submul_1_mod(v2, L, vinf, L, 64);
+    rshift_signed(v2, L, 2);                // c2 + 4 * c4
+    sub_n(v2, v2, v1, L);
+    divexact_1_mod(v2, L, 3);               // c4
+    sub_n(v1, v1, v2, L);                   // c2
+    sub_in_place(v3, L, v0, 2 * k);
+    submul_1_mod(v3, L, v1, L, 9);
+    submul_1_mod(v3, L, v2, L, 81);
+    submul_1_mod(v3, L, vinf, L, 729);
+    divexact_1_mod(v3, L, 3);               // c1 + 9 * c3 + 81 * c5
+    sub_n(vm2, vm2, vm1, L);
+    divexact_1_mod(vm2, L, 3);              // c3 + 5 * c5
+    sub_n(v3, v3, vm1, L);
+    rshift_signed(v3, L, 3);                // c3 + 10 * c5
+    sub_n(v3, v3, vm2, L);
+    divexact_1_mod(v3, L, 5);               // c5
+    submul_1_mod(vm2, L, v3, L, 5);         // c3
+    sub_n(vm1, vm1, vm2, L);
+    sub_n(vm1, vm1, v3, L);                 // c1
+
+    // Recomposition
+    const size_t rn = an + bn;
+    zero_limbs(r + 2 * k, rn - 2 * k);
+    add_shifted(r, rn, k, vm1, L);
+    add_shifted(r, rn, 2 * k, v1, L);
+    add_shifted(r, rn, 3 * k, vm2, L);
+    add_shifted(r, rn, 4 * k, v2, L);
+    add_shifted(r, rn, 5 * k, v3, L);
+    add_shifted(r, rn, 6 * k, vinf, L);
+}
+
+//--------------------------------
+// Number-theoretic transform multiplication
+//--------------------------------
+// The product is restored from the cyclic convolution of 32-bit words computed modulo three primes
+// p = c * 2^26 + 1 by the Chinese remainder theorem. Every coefficient of the convolution is less
+// than 2^25 * 2^64, which is less than the product of the primes (about 2^90.5),
+// so the result is exact. Only integer arithmetic is used. Wider limbs are split into words.
+namespace {
+    template<uint32_t P, uint32_t G>
+    struct NttPrime {
+        static constexpr uint32_t add(uint32_t a, uint32_t b) {
+            uint32_t sum = a + b;
+            return sum >= P ? sum - P : sum;
+        }
+
+        static constexpr uint32_t sub(uint32_t a, uint32_t b) {
+            return a >= b ? a - b : a + P - b;
+        }
+
+        static constexpr uint32_t mul(uint32_t a, uint32_t b) {
+            return (uint64_t) a * b % P;
+        }
+
+        static constexpr uint32_t power(uint32_t a, uint64_t power) {
+            uint32_t result = 1;
+            while (power > 0) {
+                if (is_odd(power)) {
+                    result = mul(result, a);
+                }
+                a = mul(a, a);
+                power >>= 1;
+            }
+            return result;
+        }
+
+        // roots[i] = w^i for i < n / 2, where w is a primitive n-th root of unity or its inverse
+        static void make_roots(uint32_t *roots, size_t n, bool inverse) {
+            uint32_t w = power(G, (P - 1) / n);
+            if (inverse) {
+                w = power(w, P - 2);
+            }
+            uint32_t root = 1;
+            for (size_t i = 0; i < n / 2; ++i) {
+                roots[i] = root;
+                root = mul(root, w);
+            }
+        }
+
+        // Decimation in frequency, the result is in bit-reversed order
+        static void forward(uint32_t *a, size_t n, const uint32_t *roots) {
+            for (size_t len = n; len >= 2; len >>= 1) {
+                const size_t half = len / 2, step = n / len;
+                for (size_t i = 0; i < n; i += len) {
+                    for (size_t j = 0; j < half; ++j) {
+                        uint32_t u = a[i + j], v = a[i + j + half];
+                        a[i + j] = add(u, v);
+                        a[i + j + half] = mul(sub(u, v), roots[j * step]);
+                    }
+                }
+            }
+        }
+
+        // Decimation in time, takes values in bit-reversed order. The result is multiplied by n.
+        static void inverse(uint32_t *a, size_t n, const uint32_t *roots) {
+            for (size_t len = 2; len <= n; len <<= 1) {
+                const size_t half = len / 2, step = n / len;
+                for (size_t i = 0; i < n; i += len) {
+                    for (size_t j = 0; j < half; ++j) {
+                        uint32_t u = a[i + j], v = mul(a[i + j + half], roots[j * step]);
+                        a[i + j] = add(u, v);
+                        a[i + j + half] = sub(u, v);
+                    }
+                }
+            }
+        }
+
+        static void load(uint32_t *r, const uint32_t *a, size_t an, size_t n) {
+            for (size_t i = 0; i < an; ++i) {
+                r[i] = a[i] % P;
+            }
+            for (size_t i = an; i < n; ++i) {
+                r[i] = 0;
+            }
+        }
+
+        // r[0, n) = a * b modulo (x^n - 1, P). tmp[0, n) and roots[0, n / 2) are used as a scratch space.
+        // If a and b are the same, only one forward transform is done.
+        static void convolve(uint32_t *r, uint32_t *tmp, uint32_t *roots,
+                             const uint32_t *a, size_t an, const uint32_t *b, size_t bn, size_t n) {
+            make_roots(roots, n, false);
+            load(r, a, an, n);
+            forward(r, n, roots);
+            if (a == b && an == bn) {
+                tmp = r;
+            } else {
+                load(tmp, b, bn, n);
+                forward(tmp, n, roots);
+            }
+
+            const uint32_t n_inverse = power(n % P, P - 2);
+            for (size_t i = 0; i < n; ++i) {
+                r[i] = mul(mul(r[i], tmp[i]), n_inverse);
+            }
+
+            make_roots(roots, n, true);
+            inverse(r, n, roots);
+        }
+    };
+
+    using Prime1 = NttPrime<469762049, 3>;
+    using Prime2 = NttPrime<1811939329, 13>;
+    using Prime3 = NttPrime<2013265921, 31>;
+
+    const uint64_t p1 = 469762049, p2 = 1811939329, p3 = 2013265921;
+}
+
+// Maximal length of the transform in words, 2^26 divides p - 1 for all the primes
+static const size_t max_ntt_size = (size_t) 1 << 26;
+
+static const size_t words_per_limb = sizeof(limb_t) / sizeof(uint32_t);
+
+// w[0, n * words_per_limb) = a[0, n) split into 32-bit words
+static void split_words(uint32_t *w, const limb_t *a, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < words_per_limb; ++j) {
+            w[i * words_per_limb + j] = div_by_pow_of_2(a[i], 32 * j);
+        }
+    }
+}
+
+// r[0, n) = w[0, n * words_per_limb) joined from 32-bit words
+static void join_words(limb_t *r, const uint32_t *w, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        limb_t limb = 0;
+        for (size_t j = 0; j < words_per_limb; ++j) {
+            limb |= (limb_t) mult_by_pow_of_2(w[i * words_per_limb + j], 32 * j);
+        }
+        r[i] = limb;
+    }
+}
+
+// Requires (an + bn) * words_per_limb <= max_ntt_size
+static void mul_ntt(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    const size_t wan = an * words_per_limb, wbn = bn * words_per_limb, wn = wan + wbn;
+    size_t n = 1;
+    while (n < wn) {
+        n <<= 1;
+    }
+
+    ScratchFrame frame;
+    const size_t words = 4 * n + n / 2 + 2 * wn;
+    uint32_t *r1 = (uint32_t *) frame.alloc(div_with_rounding_up(words, words_per_limb));
+    uint32_t *r2 = r1 + n, *r3 = r2 + n, *t = r3 + n, *roots = t + n;
+    uint32_t *wa = roots + n / 2, *wb = wa + wan, *wr = wb + wbn;
+    split_words(wa, a, an);
+    if (a == b && an == bn) {
+        wb = wa;
+    } else {
+        split_words(wb, b, bn);
+    }
+    Prime1::convolve(r1, t, roots, wa, wan, wb, wbn, n);
+    Prime2::convolve(r2, t, roots, wa, wan, wb, wbn, n);
+    Prime3::convolve(r3, t, roots, wa, wan, wb, wbn, n);
+
+    // Garner's algorithm: x = x1 + x2 * p1 + x3 * p1 * p2
+    const uint32_t p1_inverse = Prime2::power(p1, p2 - 2);
+    const uint32_t p1p2_inverse = Prime3::power(p1 * p2 % p3, p3 - 2);
+    const uint64_t p1p2 = p1 * p2;
+    const uint64_t mask = 0xFFFFFFFF;
+
+    uint64_t carry = 0;
+    for (size_t i = 0; i < wn; ++i) {
+        const uint32_t x1 = r1[i];
+        const uint32_t x2 = Prime2::mul(Prime2::sub(r2[i], x1), p1_inverse);
+        const uint64_t low = x1 + x2 * p1;
+        const uint32_t x3 = Prime3::mul(Prime3::sub(r3[i], low % p3), p1p2_inverse);
+
+        // carry + low + x3 * p1p2, split into words
+        const uint64_t t0 = x3 * (p1p2 & mask), t1 = x3 * (p1p2 >> 32);
+        const uint64_t s0 = (carry & mask) + (low & mask) + (t0 & mask);
+        const uint64_t s1 = (carry >> 32) + (low >> 32) + (t0 >> 32) + (t1 & mask) + (s0 >> 32);
+        const uint64_t s2 = (t1 >> 32) + (s1 >> 32);
+        wr[i] = s0 & mask;
+        carry = (s1 & mask) | (s2 << 32);
+    }
+    join_words(r, wr, an + bn);
+}
+
+//--------------------------------
+// Unbalanced multiplication
+//--------------------------------
+// Requires bn <= an. a is split into bn-limb chunks, each of them is multiplied by b
+// with a balanced algorithm and the partial products are accumulated in r.
+static void mul_unbalanced(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    mul(r, a, bn, b, bn);
+
+    ScratchFrame frame;
+    limb_t *tmp = frame.alloc(2 * bn);
+    for (size_t i = bn; i < an; i += bn) {
+        const size_t n = min(bn, an - i);
+        mul(tmp, a + i, n, b, bn);
+
+        // r[0, i + bn) already holds the sum of previous products
+        zero_limbs(r + i + bn, n);
+        add_in_place(r + i, n + bn, tmp, n + bn);
+    }
+}
+
+//--------------------------------
+// Dispatchers
+//--------------------------------
+void mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    if (a == b && an == bn) {
+        sqr(r, a, an);
+        return;
+    }
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    if (bn < max(mul_thresholds.karatsuba, min_karatsuba_size)) {
+        mul_basecase(r, a, an, b, bn);
+    } else if (bn >= mul_thresholds.ntt && (an + bn) * words_per_limb <= max_ntt_size) {
+        mul_ntt(r, a, an, b, bn);
+    } else if (bn <= (an + 1) / 2) {
+        mul_unbalanced(r, a, an, b, bn);
+    } else if (bn < max(mul_thresholds.toom3, min_toom_size)) {
+        mul_karatsuba(r, a, an, b, bn);
+    } else if (bn < max(mul_thresholds.toom4, min_toom_size)) {
+        mul_toom3(r, a, an, b, bn);
+    } else {
+        mul_toom4(r, a, an, b, bn);
+    }
+}
+
+void sqr(limb_t *r, const limb_t *a, size_t n) {
+    if (n < max(mul_thresholds.karatsuba_sqr, min_karatsuba_size)) {
+        sqr_basecase(r, a, n);
+    } else if (n >= mul_thresholds.ntt && 2 * n * words_per_limb <= max_ntt_size) {
+        mul_ntt(r, a, n, a, n);
+    } else if (n < max(mul_thresholds.toom3, min_toom_size)) {
+        sqr_karatsuba(r, a, n);
+    } else if (n < max(mul_thresholds.toom4, min_toom_size)) {
+        mul_toom3(r, a, n, a, n);
+    } else {
+        mul_toom4(r, a, n, a, n);
+    }
+}
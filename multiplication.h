@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "helpers.h"
+
+//--------------------------------
+// Multiplication thresholds
+//--------------------------------
+// Operand sizes (in limbs) starting from which the next algorithm is used.
+// Defaults are tuned for x86-64, they can be changed at runtime for a particular machine.
+struct MulThresholds {
+    size_t karatsuba = 32;
+    size_t karatsuba_sqr = 64;
+    size_t toom3 = 250;
+    size_t toom4 = 600;
+    size_t ntt = 8000;
+};
+
+extern MulThresholds mul_thresholds;
+
+//--------------------------------
+// Multiplication kernels
+//--------------------------------
+// All kernels compute r[0, an + bn) = a[0, an) * b[0, bn).
+// Limbs are stored from the least significant one, r must not overlap with a or b.
+
+// Chooses the algorithm by the size of the operands, squares if a and b are the same span
+void mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+// O(an * bn) schoolbook multiplication
+void mul_basecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+// r[0, 2n) = a[0, n)^2, cross products are computed only once on every level
+void sqr(limb_t *r, const limb_t *a, size_t n);
+
+void sqr_basecase(limb_t *r, const limb_t *a, size_t n);
@@ -0,0 +1,118 @@
+#include <bit>
+#include "reciprocal.h"
+
+// Inverses of divisors up to this size (in limbs) are computed by a plain division
+static const size_t newton_basecase_size = 32;
+
+// B^n
+static BigInteger limb_power(size_t n) {
+    return BigInteger(1) << BASE_POW * n;
+}
+
+Reciprocal::Reciprocal(const BigInteger &divisor) : m_divisor(divisor) {
+    if (divisor.is_zero()) {
+        throw std::runtime_error("Division by zero.");
+    }
+    m_shift = std::countl_zero(divisor.m_digits.back());
+    m_normalized = divisor;
+    m_normalized.m_is_positive = true;
+    m_normalized <<= m_shift;
+    m_size = m_normalized.m_digits.size();
+    m_inverse = newton_inverse(m_normalized, m_size);
+}
+
+BigInteger Reciprocal::newton_inverse(const BigInteger &d, size_t n) {
+    if (n <= newton_basecase_size) {
+        Vector<limb_t> power(2 * n + 1, 0);
+        power[2 * n] = 1;
+        BigInteger result;
+        result.m_digits = BigInteger::Digits(n + 2, 0);
+        divrem(result.m_digits.data(), nullptr, power.data(), power.size(), d.m_digits.data(), n);
+        result.remove_high_order_zeros();
+        return result;
+    }
+
+    // The inverse of the high h limbs of d gives about h correct limbs, one Newton step doubles them:
+    // x = x + x * (B^(2n) - d * x) / B^(2n)
+    const size_t h = (n + 1) / 2 + 1;
+    const size_t shift = BASE_POW * (n - h);
+    BigInteger x = newton_inverse(d >> shift, h) << shift;
+
+    const BigInteger power = limb_power(2 * n);
+    BigInteger error = power - d * x;
+    BigInteger step = (x * error) >> BASE_POW * 2 * n;
+    x += step;
+    error -= d * step;
+
+    // Now x is off by a few units at most, the error is kept equal to B^(2n) - d * x
+    while (error < 0) {
+        --x;
+        error += d;
+    }
+    while (error >= d) {
+        ++x;
+        error -= d;
+    }
+    return x;
+}
+
+void Reciprocal::reduce(BigInteger &t, BigInteger &q) const {
+    // q is estimated from the high limbs of t, the estimate is at most 2 less than the quotient
+    q = (t >> BASE_POW * (m_size - 1)) * m_inverse;
+    q >>= BASE_POW * (m_size + 1);
+    t -= q * m_normalized;
+    while (t >= m_normalized) {
+        t -= m_normalized;
+        ++q;
+    }
+}
+
+void Reciprocal::div_mod(const BigInteger &a, BigInteger &q, BigInteger &r) const {
+    const bool a_is_positive = a.m_is_positive;
+    BigInteger t = a;
+    t.m_is_positive = true;
+    t <<= m_shift;
+
+    // t is divided by blocks of m_size limbs starting from the high ones, like in the schoolbook division
+    const size_t blocks = div_with_rounding_up(t.m_digits.size(), m_size);
+    BigInteger quotient, remainder, block, block_quotient;
+    quotient.m_digits = BigInteger::Digits(blocks * m_size, 0);
+    for (size_t i = blocks; i-- > 0;) {
+        const size_t from = i * m_size, to = min(from + m_size, t.m_digits.size());
+        block.m_digits = BigInteger::Digits(m_size + remainder.m_digits.size(), 0);
+        for (size_t j = from; j < to; ++j) {
+            block.m_digits[j - from] = t.m_digits[j];
+        }
+        for (size_t j = 0; j < remainder.m_digits.size(); ++j) {
+            block.m_digits[m_size + j] = remainder.m_digits[j];
+        }
+        block.remove_high_order_zeros();
+
+        reduce(block, block_quotient);
+        for (size_t j = 0; j < block_quotient.m_digits.size(); ++j) {
+            quotient.m_digits[from + j] = block_quotient.m_digits[j];
+        }
+        std::swap(remainder, block);
+    }
+    quotient.remove_high_order_zeros();
+    remainder >>= m_shift;
+
+    q = std::move(quotient);
+    q.m_is_positive = a_is_positive == m_divisor.m_is_positive;
+    q.check_zero_sign();
+    r = std::move(remainder);
+    r.m_is_positive = a_is_positive;
+    r.check_zero_sign();
+}
+
+BigInteger Reciprocal::divide(const BigInteger &a) const {
+    BigInteger q, r;
+    div_mod(a, q, r);
+    return q;
+}
+
+BigInteger Reciprocal::remainder(const BigInteger &a) const {
+    BigInteger q, r;
+    div_mod(a, q, r);
+    return r;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "biginteger.h"
+
+//--------------------------------
+// Reciprocal
+//--------------------------------
+// Precomputed inverse of a divisor. A division by it costs two multiplications (Barrett reduction),
+// so it pays off for huge divisors and when many numbers are divided by the same divisor.
+class Reciprocal {
+    BigInteger m_divisor;
+    // |divisor| shifted so that its high bit is set, it has m_size limbs
+    BigInteger m_normalized;
+    // floor(B^(2 * m_size) / m_normalized), computed by Newton's iteration
+    BigInteger m_inverse;
+    size_t m_size;
+    uint32_t m_shift;
+
+public:
+    explicit Reciprocal(const BigInteger &divisor);
+
+    [[nodiscard]] const BigInteger &divisor() const { return m_divisor; }
+
+    // q = a / divisor, r = a % divisor, rounded the same way as operator/ and operator%.
+    // q and r may be the same objects as a but not as each other.
+    void div_mod(const BigInteger &a, BigInteger &q, BigInteger &r) const;
+
+    [[nodiscard]] BigInteger divide(const BigInteger &a) const;
+
+    [[nodiscard]] BigInteger remainder(const BigInteger &a) const;
+
+private:
+    // q = t / m_normalized, t = t % m_normalized. Requires 0 <= t < B^m_size * m_normalized.
+    void reduce(BigInteger &t, BigInteger &q) const;
+
+    // floor(B^(2n) / d) for d of n limbs with the high bit set
+    static BigInteger newton_inverse(const BigInteger &d, size_t n);
+};
@@ -0,0 +1,65 @@
+#include <cstring>
+#include <new>
+#include "scratch.h"
+
+// Size (in limbs) of the first chunk, every next one is at least twice as large
+static const size_t min_chunk_size = 1 << 12;
+
+namespace {
+    // Chunks are never moved, so the limbs given out stay valid when the stack grows
+    struct Chunk {
+        Chunk *next;
+        size_t size;
+        size_t used;
+
+        limb_t *limbs() { return (limb_t *) (this + 1); }
+    };
+
+    struct ScratchStack {
+        Chunk *first = nullptr;
+        Chunk *current = nullptr;
+
+        ~ScratchStack() {
+            while (first) {
+                Chunk *next = first->next;
+                ::operator delete(first);
+                first = next;
+            }
+        }
+    };
+
+    thread_local ScratchStack stack;
+}
+
+ScratchFrame::ScratchFrame() : m_chunk(stack.current), m_used(stack.current ? stack.current->used : 0) {}
+
+ScratchFrame::~ScratchFrame() {
+    stack.current = (Chunk *) m_chunk;
+    if (stack.current) {
+        stack.current->used = m_used;
+    }
+}
+
+limb_t *ScratchFrame::alloc(size_t n) {
+    Chunk *chunk = stack.current;
+    if (!chunk || chunk->used + n > chunk->size) {
+        // The next kept chunk is used if it is large enough, otherwise a new one is inserted before it
+        Chunk *next = chunk ? chunk->next : stack.first;
+        if (!next || next->size < n) {
+            size_t size = chunk ? 2 * chunk->size : min_chunk_size;
+            size = size > n ? size : n;
+            auto *inserted = (Chunk *) ::operator new(sizeof(Chunk) + size * sizeof(limb_t));
+            inserted->next = next;
+            inserted->size = size;
+            (chunk ? chunk->next : stack.first) = inserted;
+            next = inserted;
+        }
+        next->used = 0;
+        stack.current = chunk = next;
+    }
+
+    limb_t *limbs = chunk->limbs() + chunk->used;
+    chunk->used += n;
+    std::memset(limbs, 0, n * sizeof(limb_t));
+    return limbs;
+}
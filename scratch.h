@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "helpers.h"
+
+//--------------------------------
+// Scratch space
+//--------------------------------
+// Per-thread stack of limbs for temporaries of the kernels (like TMP_ALLOC in GMP).
+// A frame gives back everything allocated through it when destroyed, so frames must be nested.
+// The thread keeps the memory, once it has grown enough the kernels don't touch the heap.
+class ScratchFrame {
+    void *m_chunk;
+    size_t m_used;
+
+public:
+    ScratchFrame();
+
+    ~ScratchFrame();
+
+    ScratchFrame(const ScratchFrame &) = delete;
+
+    ScratchFrame &operator=(const ScratchFrame &) = delete;
+
+    // n zeroed limbs, valid until the frame is destroyed
+    limb_t *alloc(size_t n);
+};
@@ -1,7 +1,37 @@
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <sstream>
 #include <string>
+#include <random>
 #include <gtest/gtest.h>
 
 #include "biginteger.h"
+#include "reciprocal.h"
+#include "montgomery.h"
+#include "allocator.h"
+#include "limbs.h"
+#include "limbs_x86.h"
+#include "decimal_parser.h"
+
+// Counts the allocations of the global heap to check that the arithmetic reuses memory
+static size_t heap_allocations = 0;
+
+void *operator new(size_t size) {
+    ++heap_allocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
 
 TEST(correctness, one_plus_one)
 {
@@ -683,3 +713,1275 @@ TEST(correctness, converting_ctor3)
     EXPECT_TRUE(a == b);
     EXPECT_TRUE(a == c);
 }
+
+namespace
+{
+    BigInteger random_big_integer(size_t limbs, std::mt19937 &gen)
+    {
+        BigInteger result;
+        for (size_t i = 0; i < limbs * (BASE_POW / 32); ++i) {
+            result <<= 32;
+            result += BigInteger(gen());
+        }
+        return result;
+    }
+
+    class mul_thresholds_guard
+    {
+        MulThresholds saved = mul_thresholds;
+    public:
+        ~mul_thresholds_guard() { mul_thresholds = saved; }
+    };
+
+    BigInteger mul_schoolbook(const BigInteger &a, const BigInteger &b)
+    {
+        mul_thresholds_guard guard;
+        mul_thresholds.karatsuba = std::numeric_limits<size_t>::max();
+        return a * b;
+    }
+
+    class div_thresholds_guard
+    {
+        DivThresholds saved = div_thresholds;
+    public:
+        ~div_thresholds_guard() { div_thresholds = saved; }
+    };
+
+    BigInteger div_schoolbook(const BigInteger &a, const BigInteger &b)
+    {
+        div_thresholds_guard guard;
+        div_thresholds.burnikel_ziegler = std::numeric_limits<size_t>::max();
+        div_thresholds.barrett = std::numeric_limits<size_t>::max();
+        return a / b;
+    }
+
+    class counting_allocator : public Allocator
+    {
+    public:
+        size_t allocations = 0, deallocations = 0;
+
+        void *allocate(size_t bytes, size_t) override { ++allocations; return ::operator new(bytes); }
+
+        void deallocate(void *p, size_t, size_t) override { ++deallocations; ::operator delete(p); }
+    };
+}
+
+TEST(correctness, mul_karatsuba)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+
+    std::mt19937 gen(42);
+    for (size_t n : {4, 5, 7, 16, 33, 100, 257}) {
+        BigInteger a = random_big_integer(n, gen);
+        BigInteger b = -random_big_integer(n - 1, gen);
+
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(a, a), a * a);
+    }
+}
+
+TEST(correctness, mul_karatsuba_unbalanced)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+
+    std::mt19937 gen(7);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{300, 17}, {1000, 40}, {129, 64}, {65, 33}}) {
+        BigInteger a = random_big_integer(an, gen);
+        BigInteger b = random_big_integer(bn, gen);
+
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(b, a), b * a);
+    }
+}
+
+TEST(correctness, mul_karatsuba_carries)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+
+    // (2^n - 1)^2 = 2^2n - 2^(n + 1) + 1
+    BigInteger a = (BigInteger(1) << BASE_POW * 77) - 1;
+    EXPECT_EQ((BigInteger(1) << 2 * BASE_POW * 77) - (BigInteger(1) << (BASE_POW * 77 + 1)) + 1, a * a);
+}
+
+TEST(correctness, mul_by_zero_sign)
+{
+    EXPECT_EQ(0, BigInteger(0) * BigInteger(-5));
+    EXPECT_EQ("0", to_string(BigInteger(0) * BigInteger(-5)));
+}
+
+TEST(correctness, mul_toom3)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+    mul_thresholds.toom3 = 8;
+    mul_thresholds.toom4 = std::numeric_limits<size_t>::max();
+
+    std::mt19937 gen(3);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{8, 8}, {9, 5}, {30, 29}, {100, 51}, {243, 200}, {500, 400}}) {
+        BigInteger a = random_big_integer(an, gen);
+        BigInteger b = -random_big_integer(bn, gen);
+
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(b, b), b * b);
+    }
+}
+
+TEST(correctness, mul_toom4)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+    mul_thresholds.toom3 = 8;
+    mul_thresholds.toom4 = 16;
+
+    std::mt19937 gen(4);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{16, 16}, {17, 9}, {64, 63}, {101, 77}, {512, 300}, {1000, 1000}}) {
+        BigInteger a = random_big_integer(an, gen);
+        BigInteger b = random_big_integer(bn, gen);
+
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(a, a), a * a);
+    }
+}
+
+TEST(correctness, mul_toom_carries)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+    mul_thresholds.toom3 = 8;
+    mul_thresholds.toom4 = 40;
+
+    for (size_t n : {20, 33, 150}) {
+        // (2^m - 1)^2 = 2^2m - 2^(m + 1) + 1, (2^m - 1) * 2^(m - 1) has long runs of zero limbs
+        BigInteger a = (BigInteger(1) << BASE_POW * n) - 1;
+        BigInteger b = BigInteger(1) << BASE_POW * n - 1;
+        EXPECT_EQ((BigInteger(1) << 2 * BASE_POW * n) - (BigInteger(1) << (BASE_POW * n + 1)) + 1, a * a);
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(a, b + 1), a * (b + 1));
+    }
+}
+
+TEST(correctness, mul_ntt)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.ntt = 8;
+
+    std::mt19937 gen(5);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{8, 8}, {9, 8}, {100, 99}, {1000, 10}, {777, 555}, {2048, 2048}}) {
+        BigInteger a = random_big_integer(an, gen);
+        BigInteger b = -random_big_integer(bn, gen);
+
+        EXPECT_EQ(mul_schoolbook(a, b), a * b);
+        EXPECT_EQ(mul_schoolbook(a, a), a * a);
+    }
+
+    // Coefficients of the convolution are close to their maximum
+    BigInteger a = (BigInteger(1) << BASE_POW * 3000) - 1;
+    EXPECT_EQ((BigInteger(1) << 2 * BASE_POW * 3000) - (BigInteger(1) << (BASE_POW * 3000 + 1)) + 1, a * a);
+}
+
+TEST(correctness, square)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba = 4;
+    mul_thresholds.karatsuba_sqr = 4;
+    mul_thresholds.toom3 = 16;
+    mul_thresholds.toom4 = 64;
+    mul_thresholds.ntt = 300;
+
+    std::mt19937 gen(6);
+    for (size_t n : {1, 2, 3, 4, 5, 9, 17, 40, 100, 250, 400, 1000}) {
+        BigInteger a = -random_big_integer(n, gen);
+        BigInteger expected = mul_schoolbook(a, a + 1) - a;
+
+        BigInteger b = a;
+        EXPECT_EQ(expected, b.square());
+        EXPECT_EQ(expected, b);
+        EXPECT_EQ(expected, a * a);
+        EXPECT_EQ(expected, a * -a * -1);
+        EXPECT_EQ(-expected, a * +a);
+
+        BigInteger c = a;
+        c *= c;
+        EXPECT_EQ(expected, c);
+    }
+}
+
+TEST(correctness, square_carries)
+{
+    mul_thresholds_guard guard;
+    mul_thresholds.karatsuba_sqr = 4;
+    mul_thresholds.toom3 = 16;
+    mul_thresholds.toom4 = 64;
+
+    for (size_t n : {1, 5, 33, 150}) {
+        BigInteger a = (BigInteger(1) << BASE_POW * n) - 1;
+        EXPECT_EQ((BigInteger(1) << 2 * BASE_POW * n) - (BigInteger(1) << (BASE_POW * n + 1)) + 1, a.square());
+    }
+}
+
+TEST(correctness, string_conv_long)
+{
+    std::mt19937 gen(8);
+    for (size_t digits : {9, 10, 100, 289, 290, 1000, 5000, 20001}) {
+        std::string s(digits, '0');
+        for (char &c : s) {
+            c = (char) ('0' + gen() % 10);
+        }
+        s[0] = '1' + gen() % 9;
+
+        EXPECT_EQ(s, to_string(BigInteger(s)));
+        EXPECT_EQ("-" + s, to_string(BigInteger("-" + s)));
+    }
+
+    // Long runs of zeros and nines
+    BigInteger p = pow(BigInteger(10), 3000);
+    EXPECT_EQ("1" + std::string(3000, '0'), to_string(p));
+    EXPECT_EQ(std::string(3000, '9'), to_string(p - 1));
+    EXPECT_EQ("1" + std::string(2999, '0') + "1", to_string(p + 1));
+    EXPECT_EQ("-1" + std::string(1500, '0') + "7" + std::string(1499, '0'),
+              to_string(-p - 7 * pow(BigInteger(10), 1499)));
+}
+
+TEST(correctness, div_long_add_back)
+{
+    // Patterns that make the quotient digit estimate one too large
+    std::mt19937 gen(9);
+    for (const char *v_str : {"1000000000000000000000000000000000000000000000000000000000000000000000000",
+                              "340282366920938463444927863358058659841",  // 2^128 - 2^64 + 1
+                              "18446744073709551617"}) {                  // 2^64 + 1
+        BigInteger v(v_str);
+        for (size_t n : {2, 3, 10, 40}) {
+            BigInteger q = random_big_integer(n, gen);
+            BigInteger r = v - 1 - random_big_integer(1, gen);
+            BigInteger u = q * v + r;
+
+            EXPECT_EQ(q, u / v);
+            EXPECT_EQ(r, u % v);
+            EXPECT_EQ(-q, -u / v);
+        }
+    }
+
+    EXPECT_EQ(0, BigInteger(5) / BigInteger("100000000000000000000"));
+    EXPECT_EQ("0", to_string(BigInteger(-3) / 5));
+}
+
+TEST(correctness, string_conv_views)
+{
+    std::string s = "12345678901234567890123";
+    std::string_view view = s;
+
+    EXPECT_EQ(BigInteger(s), BigInteger(view));
+    EXPECT_EQ(BigInteger("12345"), BigInteger(view.substr(0, 5)));
+    EXPECT_EQ(BigInteger("-1234"), BigInteger("-1234567", 5));
+    EXPECT_EQ(BigInteger(67890), BigInteger(s.data() + 5, 5));
+    EXPECT_THROW(BigInteger(s.data(), 0), std::invalid_argument);
+}
+
+TEST(correctness, string_conv_long_parse)
+{
+    EXPECT_EQ(pow(BigInteger(10), 5000), BigInteger("1" + std::string(5000, '0')));
+    EXPECT_EQ(pow(BigInteger(10), 5000) - 1, BigInteger(std::string(5000, '9')));
+    EXPECT_EQ(BigInteger(123), BigInteger(std::string(3000, '0') + "123"));
+    EXPECT_EQ(BigInteger(0), BigInteger("-" + std::string(3000, '0')));
+    EXPECT_EQ("0", to_string(BigInteger("-" + std::string(3000, '0'))));
+
+    std::string s(4000, '5');
+    s[1234] = 'x';
+    EXPECT_THROW(BigInteger{s}, std::invalid_argument);
+    s[1234] = '-';
+    EXPECT_THROW(BigInteger{s}, std::invalid_argument);
+}
+
+TEST(correctness, div_burnikel_ziegler)
+{
+    div_thresholds_guard guard;
+    div_thresholds.burnikel_ziegler = 4;
+
+    std::mt19937 gen(21);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{8, 4}, {9, 5}, {40, 20}, {41, 13}, {100, 33},
+                          {300, 100}, {301, 150}, {500, 7}, {1000, 400}}) {
+        BigInteger a = random_big_integer(an, gen);
+        BigInteger b = -random_big_integer(bn, gen);
+        BigInteger q = a / b;
+
+        EXPECT_EQ(div_schoolbook(a, b), q);
+        BigInteger r = a - q * b;
+        EXPECT_TRUE(r >= 0 && r < -b);
+    }
+}
+
+TEST(correctness, div_burnikel_ziegler_carries)
+{
+    div_thresholds_guard guard;
+    div_thresholds.burnikel_ziegler = 4;
+
+    // Limbs of all ones and divisors just above a power of the base make the recursive quotient overflow
+    std::mt19937 gen(22);
+    for (size_t n : {16, 50, 129}) {
+        BigInteger ones = (BigInteger(1) << (BASE_POW * 2 * n)) - 1;
+        BigInteger b = (BigInteger(1) << (BASE_POW * n - 1)) + 1;
+        BigInteger q = random_big_integer(n, gen);
+        BigInteger r = b - 1;
+
+        EXPECT_EQ(div_schoolbook(ones, b), ones / b);
+        EXPECT_EQ(q, (q * b + r) / b);
+        EXPECT_EQ(q + 1, (q * b + b) / b);
+        EXPECT_EQ(1, ones / ones);
+    }
+}
+
+TEST(correctness, divmod)
+{
+    std::mt19937 gen(23);
+    for (auto [an, bn] : {std::pair<size_t, size_t>{1, 1}, {3, 1}, {2, 5}, {40, 20}, {300, 100}}) {
+        for (int signs = 0; signs < 4; ++signs) {
+            BigInteger a = random_big_integer(an, gen), b = random_big_integer(bn, gen) + 1;
+            if (signs & 1) a = -a;
+            if (signs & 2) b = -b;
+
+            auto [q, r] = a.divmod(b);
+            EXPECT_EQ(a / b, q);
+            EXPECT_EQ(a - (a / b) * b, r);
+            EXPECT_TRUE(r == 0 || (r < 0) == (a < 0));
+        }
+    }
+
+    BigInteger q, r;
+    div_mod(BigInteger(-7), BigInteger(2), q, r);
+    EXPECT_EQ(-3, q);
+    EXPECT_EQ(-1, r);
+    div_mod(BigInteger(6), BigInteger(-3), q, r);
+    EXPECT_EQ("0", to_string(r));
+    EXPECT_THROW(BigInteger(1).divmod(0), std::runtime_error);
+}
+
+TEST(correctness, divmod_aliasing)
+{
+    BigInteger a("123456789012345678901234567890"), b("987654321987");
+    BigInteger q = a, r = b;
+    div_mod(q, r, q, r);
+    EXPECT_EQ(a / b, q);
+    EXPECT_EQ(a % b, r);
+
+    BigInteger x = a;
+    div_mod(x, b, r, x);
+    EXPECT_EQ(a / b, r);
+    EXPECT_EQ(a % b, x);
+}
+
+TEST(correctness, reciprocal)
+{
+    std::mt19937 gen(24);
+    for (size_t bn : {1, 2, 31, 32, 33, 70, 150, 400}) {
+        BigInteger b = random_big_integer(bn, gen) + 1;
+        if (bn % 2) b = -b;
+        Reciprocal reciprocal(b);
+        EXPECT_EQ(b, reciprocal.divisor());
+
+        for (size_t an : {bn / 2 + 1, bn, bn + 1, 2 * bn, 5 * bn + 3}) {
+            BigInteger a = random_big_integer(an, gen);
+            if (an % 3 == 0) a = -a;
+
+            BigInteger q, r;
+            reciprocal.div_mod(a, q, r);
+            EXPECT_EQ(a / b, q);
+            EXPECT_EQ(a % b, r);
+            EXPECT_EQ(q, reciprocal.divide(a));
+            EXPECT_EQ(r, reciprocal.remainder(a));
+        }
+        EXPECT_EQ(1, reciprocal.divide(b));
+        EXPECT_EQ("0", to_string(reciprocal.remainder(-b * 3)));
+    }
+    EXPECT_THROW(Reciprocal(BigInteger(0)), std::runtime_error);
+}
+
+TEST(correctness, div_barrett)
+{
+    div_thresholds_guard guard;
+    div_thresholds.barrett = 40;
+
+    // Divisors just below a power of two make the estimated quotient the least accurate
+    std::mt19937 gen(25);
+    for (size_t n : {40, 64, 100}) {
+        BigInteger b = (BigInteger(1) << BASE_POW * n) - 1;
+        BigInteger a = random_big_integer(6 * n, gen);
+
+        EXPECT_EQ(div_schoolbook(a, b), a / b);
+        EXPECT_EQ(a - a / b * b, a % b);
+        EXPECT_EQ(div_schoolbook(-a, b + 2), -a / (b + 2));
+    }
+}
+
+TEST(correctness, montgomery_mul)
+{
+    std::mt19937 gen(26);
+    for (size_t n : {1, 2, 5, 40, 100}) {
+        BigInteger m = random_big_integer(n, gen) | 1;
+        MontgomeryContext context(m);
+        EXPECT_EQ(n, context.size());
+
+        Vector<limb_t> x(n, 0), y(n, 0), z(n, 0);
+        for (int i = 0; i < 5; ++i) {
+            BigInteger a = random_big_integer(n + 1, gen), b = -random_big_integer(n, gen);
+            BigInteger a_mod = a % m, b_mod = (b % m + m) % m;
+            context.to_montgomery(x.data(), a);
+            context.to_montgomery(y.data(), b);
+            EXPECT_EQ(a_mod, context.from_montgomery(x.data()));
+            EXPECT_EQ(b_mod, context.from_montgomery(y.data()));
+
+            context.mul(z.data(), x.data(), y.data());
+            EXPECT_EQ(a_mod * b_mod % m, context.from_montgomery(z.data()));
+            context.sqr(x.data(), x.data());
+            EXPECT_EQ(a_mod * a_mod % m, context.from_montgomery(x.data()));
+        }
+    }
+
+    // The largest residues make the result exceed the modulus before the final subtraction
+    BigInteger m = (BigInteger(1) << 3 * BASE_POW) - 1;
+    MontgomeryContext context(m);
+    Vector<limb_t> x(3, 0);
+    context.to_montgomery(x.data(), m - 1);
+    context.mul(x.data(), x.data(), x.data());
+    EXPECT_EQ(1, context.from_montgomery(x.data()));
+}
+
+TEST(correctness, montgomery_pow_mod)
+{
+    MontgomeryContext small(BigInteger(1000000007));
+    EXPECT_EQ(1, small.pow_mod(5, 0));
+    EXPECT_EQ(500000004, small.pow_mod(2, 1000000005));  // inverse of 2 by Fermat's theorem
+    EXPECT_EQ(1000000006, small.pow_mod(-1, 12345));
+
+    std::mt19937 gen(27);
+    BigInteger m = random_big_integer(20, gen) * 2 + 1, base = random_big_integer(25, gen);
+    MontgomeryContext context(m);
+    BigInteger expected = 1;
+    for (int e = 0; e < 40; ++e) {
+        EXPECT_EQ(expected, context.pow_mod(base, e));
+        expected = expected * base % m;
+    }
+    EXPECT_EQ(0, MontgomeryContext(1).pow_mod(3, 3));
+
+    EXPECT_THROW(MontgomeryContext(BigInteger(10)), std::invalid_argument);
+    EXPECT_THROW(MontgomeryContext(BigInteger(-7)), std::invalid_argument);
+    EXPECT_THROW(small.pow_mod(2, -1), std::invalid_argument);
+}
+
+TEST(correctness, pow_mod)
+{
+    auto pow_mod_naive = [](BigInteger base, BigInteger exp, const BigInteger &mod) {
+        BigInteger result = 1 % mod;
+        base = (base % mod + mod) % mod;
+        for (; exp > 0; exp /= 2) {
+            if (exp % 2 == 1) {
+                result = result * base % mod;
+            }
+            base = base * base % mod;
+        }
+        return result;
+    };
+
+    std::mt19937 gen(28);
+    for (size_t n : {1, 3, 12, 40}) {
+        for (size_t en : {1, 3, 30}) {
+            BigInteger odd = random_big_integer(n, gen) | 1, even = odd + 1, base = -random_big_integer(n + 2, gen);
+            BigInteger exp = random_big_integer(en, gen);
+
+            EXPECT_EQ(pow_mod_naive(base, exp, odd), pow_mod(base, exp, odd));
+            EXPECT_EQ(pow_mod_naive(base, exp, even), pow_mod(base, exp, -even));
+        }
+    }
+
+    EXPECT_EQ(1, pow_mod(0, 0, 10));
+    EXPECT_EQ(0, pow_mod(7, 0, 1));
+    EXPECT_EQ(76, pow_mod(2, BigInteger("1000000000000000000000"), 100));  // 2^(20k) ends with 76
+    EXPECT_THROW(pow_mod(2, -1, 5), std::invalid_argument);
+    EXPECT_THROW(pow_mod(2, 3, 0), std::runtime_error);
+}
+
+TEST(correctness, pow)
+{
+    EXPECT_EQ(1, pow(BigInteger(0), 0));
+    EXPECT_EQ(-125, pow(BigInteger(-5), 3u));
+    EXPECT_EQ(BigInteger(1) << 640, pow(BigInteger(1024), (uint64_t) 64));
+    EXPECT_EQ(BigInteger("1" + std::string(300, '0')), pow(BigInteger(10), 300));
+    EXPECT_THROW(pow(BigInteger(2), -1), std::invalid_argument);
+}
+
+TEST(correctness, vector_inline_storage)
+{
+    Vector<uint32_t, 4> v;
+    EXPECT_EQ(4, v.capacity());
+    for (uint32_t i = 0; i < 10; ++i) {
+        v.push_back(i);
+    }
+    Vector<uint32_t, 4> copy = v, small(3, 7);
+    Vector<uint32_t, 4> moved_small = std::move(small);
+    EXPECT_EQ(3, moved_small.size());
+    EXPECT_EQ(7, moved_small[2]);
+    EXPECT_EQ(0, small.size());
+
+    // A heap buffer is taken over by a vector with another inline capacity
+    const uint32_t *data = v.data();
+    Vector<uint32_t> heap = std::move(v);
+    EXPECT_EQ(data, heap.data());
+    EXPECT_EQ(0, v.size());
+    for (uint32_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(i, heap[i]);
+        EXPECT_EQ(i, copy[i]);
+    }
+
+    copy.resize(2);
+    copy.resize(5);
+    EXPECT_EQ(1, copy[1]);
+    EXPECT_EQ(0, copy[4]);
+    copy = moved_small;
+    EXPECT_EQ(3, copy.size());
+    EXPECT_EQ(7, copy[0]);
+}
+
+TEST(correctness, small_values_grow)
+{
+    // Values cross the inline storage size in both directions
+    BigInteger a = 1;
+    for (int i = 0; i < 200; ++i) {
+        a *= 3;
+    }
+    BigInteger b = a;
+    for (int i = 0; i < 200; ++i) {
+        b /= 3;
+    }
+    EXPECT_EQ(1, b);
+    EXPECT_EQ(a, pow(BigInteger(3), 200));
+
+    BigInteger c = (BigInteger(1) << 127) + 5, d = c;
+    c -= d;
+    EXPECT_EQ(0, c);
+    c = std::move(d);
+    EXPECT_EQ((BigInteger(1) << 127) + 5, c);
+}
+
+TEST(correctness, allocator_scope)
+{
+    counting_allocator counter;
+    BigInteger outside = pow(BigInteger(7), 100);
+    {
+        AllocatorScope scope(counter);
+        BigInteger inside = pow(BigInteger(7), 100);
+        EXPECT_EQ(outside, inside);
+        EXPECT_GT(counter.allocations, 0);
+
+        // Small values stay in the inline storage
+        const size_t allocations = counter.allocations;
+        BigInteger small = 12345;
+        small *= 678;
+        EXPECT_EQ(allocations, counter.allocations);
+    }
+    EXPECT_EQ(counter.allocations, counter.deallocations);
+    EXPECT_EQ(nullptr, current_allocator);
+}
+
+TEST(correctness, arena)
+{
+    Arena arena(1024);
+    BigInteger result;
+    for (int round = 0; round < 3; ++round) {
+        {
+            AllocatorScope scope(arena);
+            BigInteger a = pow(BigInteger(3), 5000), b = pow(BigInteger(5), 3000);
+            // The result made in the arena is moved out into a vector of the global heap, so it is copied
+            result = a * b / 7;
+        }
+        arena.reset();
+    }
+    EXPECT_EQ(pow(BigInteger(3), 5000) * pow(BigInteger(5), 3000) / 7, result);
+
+    // The last allocation can be given back and reused
+    void *p = arena.allocate(100, 8);
+    arena.deallocate(p, 100, 8);
+    EXPECT_EQ(p, arena.allocate(64, 8));
+    EXPECT_EQ(0, (uintptr_t) arena.allocate(3, 16) % 16);
+}
+
+TEST(correctness, arena_conversion)
+{
+    // The powers of 10 are cached when a value of 1000 limbs is converted for the first time,
+    // they must not be taken from the arena that is current then
+    const BigInteger a = pow(BigInteger(7), 11400) + 1;
+    std::string s;
+    Arena arena;
+    {
+        AllocatorScope scope(arena);
+        s = to_string(a);
+        EXPECT_EQ(a, BigInteger(s));
+    }
+    arena.reset();
+    {
+        // The reused arena overwrites whatever was taken from it before
+        AllocatorScope scope(arena);
+        EXPECT_EQ(pow(BigInteger(3), 20000), pow(BigInteger(9), 10000));
+    }
+    EXPECT_EQ(s, to_string(a));
+    EXPECT_EQ(a, BigInteger(s));
+}
+
+TEST(correctness, limb_pool)
+{
+    LimbPool pool;
+    void *p = pool.allocate(100, 4);
+    pool.deallocate(p, 100, 4);
+    void *q = pool.allocate(128, 4), *r = pool.allocate(100, 4);
+    EXPECT_EQ(p, q);
+    EXPECT_NE(p, r);
+    pool.deallocate(q, 128, 4);
+    pool.deallocate(r, 100, 4);
+
+    BigInteger expected = pow(BigInteger(11), 2000) % pow(BigInteger(13), 700);
+    AllocatorScope scope(pool);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(expected, pow(BigInteger(11), 2000) % pow(BigInteger(13), 700));
+    }
+}
+
+TEST(correctness, scratch_steady_state)
+{
+    const BigInteger a = pow(BigInteger(3), 40000), b = pow(BigInteger(7), 9000) + 1, m = pow(BigInteger(5), 3000);
+    BigInteger c, q, r;
+    auto round = [&] {
+        c = a;
+        c *= b;
+        c.square();
+        div_mod(c, b, q, r);
+        c %= m;
+        q /= m;
+        c = a;
+        c *= c;
+    };
+
+    // The first round grows the buffers and the scratch space, the next ones reuse them
+    round();
+    const size_t allocations = heap_allocations;
+    round();
+    round();
+    EXPECT_EQ(allocations, heap_allocations);
+    EXPECT_EQ(pow(BigInteger(3), 80000), c);
+}
+
+TEST(correctness, increment_decrement)
+{
+    BigInteger a("4294967295");
+    EXPECT_EQ(BigInteger("4294967296"), ++a);
+    EXPECT_EQ(BigInteger("4294967295"), --a);
+    BigInteger b("-18446744073709551616");
+    EXPECT_EQ(BigInteger("-18446744073709551615"), ++b);
+    EXPECT_EQ(BigInteger("-18446744073709551616"), --b);
+
+    BigInteger c = -1;
+    EXPECT_EQ(BigInteger(0), ++c);
+    EXPECT_EQ(BigInteger(-1), --c);
+    EXPECT_EQ(BigInteger(-1), c++);
+    EXPECT_EQ(BigInteger(0), c);
+    EXPECT_EQ(BigInteger(0), c--);
+    EXPECT_EQ(BigInteger(-1), c);
+}
+
+TEST(correctness, native_operands)
+{
+    const BigInteger a("-123456789012345678901234567890");
+    const int64_t values[] = {0, 1, -1, 7, -4294967296, INT64_MAX, INT64_MIN};
+    for (int64_t v : values) {
+        EXPECT_EQ(a + BigInteger(v), a + v);
+        EXPECT_EQ(a - BigInteger(v), a - v);
+        EXPECT_EQ(a * BigInteger(v), a * v);
+        if (v != 0) {
+            EXPECT_EQ(a / BigInteger(v), a / v);
+            EXPECT_EQ(a % BigInteger(v), a % v);
+        }
+    }
+    EXPECT_EQ(a + BigInteger(UINT64_MAX), a + UINT64_MAX);
+    EXPECT_EQ(a * BigInteger(UINT64_MAX), a * UINT64_MAX);
+    EXPECT_EQ(a / BigInteger(UINT64_MAX), a / UINT64_MAX);
+    EXPECT_EQ(a % BigInteger(UINT64_MAX), a % UINT64_MAX);
+    EXPECT_EQ(BigInteger(-3), BigInteger(5) - 8u);
+    EXPECT_EQ(BigInteger(0), BigInteger(-5) % 5);
+    EXPECT_THROW(BigInteger(5) /= 0, std::runtime_error);
+    EXPECT_THROW(BigInteger(5) %= 0ull, std::runtime_error);
+}
+
+TEST(correctness, add_subtract_in_place)
+{
+    BigInteger a = pow(BigInteger(3), 1000), b = -pow(BigInteger(3), 1001);
+    BigInteger c = a;
+    c += b;
+    EXPECT_EQ(-2 * a, c);
+    c -= b;
+    EXPECT_EQ(a, c);
+    c += c;
+    EXPECT_EQ(2 * a, c);
+    c -= c;
+    EXPECT_EQ(BigInteger(0), c);
+
+    // Subtraction of a longer number with another sign reuses the buffer and doesn't copy the operand
+    c = a;
+    c.square();
+    c -= a;
+    c -= b;
+    const size_t allocations = heap_allocations;
+    for (int i = 0; i < 3; ++i) {
+        c += b;
+        c -= b;
+        c += -1;
+        ++c;
+    }
+    EXPECT_EQ(allocations, heap_allocations);
+    EXPECT_EQ(a * a - a - b, c);
+}
+
+TEST(correctness, limb_kernels)
+{
+    const limb_t ones = ~(limb_t) 0;
+    const BigInteger limb_base = BigInteger(1) << BASE_POW;
+    auto value = [&](const limb_t *a) {
+        return (BigInteger(a[2]) * limb_base + BigInteger(a[1])) * limb_base + BigInteger(a[0]);
+    };
+
+    // a = 2 * B^2 - 1
+    limb_t a[3] = {ones, ones, 1}, b[3] = {1, 0, 0}, r[3];
+    EXPECT_EQ(0u, add_n(r, a, b, 3));
+    EXPECT_EQ(2 * limb_base * limb_base, value(r));
+    EXPECT_EQ(1u, sub_n(r, b, a, 3));
+    EXPECT_EQ(1, cmp(a, b, 3));
+    EXPECT_EQ(0, cmp(a, a, 3));
+
+    EXPECT_EQ(0u, mul_1(r, a, 3, 3));
+    EXPECT_EQ(value(a) * 3, value(r));
+    EXPECT_EQ(0u, submul_1(r, a, 3, 3));
+    EXPECT_EQ(0, value(r));
+    EXPECT_EQ(1u, addmul_1(r, a, 3, ones));
+    EXPECT_EQ(value(a) * ones - limb_base * limb_base * limb_base, value(r));
+
+    copy_limbs(r, a, 3);
+    EXPECT_EQ(0u, lshift(r, r, 3, 4));
+    EXPECT_EQ(value(a) << 4, value(r));
+    EXPECT_EQ(0u, rshift(r, r, 3, 4));
+    EXPECT_EQ(0, cmp(r, a, 3));
+    EXPECT_EQ(0xFu, rshift(r, a, 3, 4));
+    EXPECT_EQ(value(a) >> 4, value(r));
+    EXPECT_EQ(value(a) % 7, divrem_1(r, a, 3, 7));
+    EXPECT_EQ(value(a) / 7, value(r));
+}
+
+TEST(correctness, limb_kernels_long_spans)
+{
+    // Covers the block loops of the CPU-specific kernels and the tails after them
+    const BigInteger limb_base = BigInteger(1) << BASE_POW;
+    auto value = [&](const limb_t *a, size_t n) {
+        BigInteger result;
+        for (size_t i = n; i-- > 0;) {
+            result = result * limb_base + BigInteger(a[i]);
+        }
+        return result;
+    };
+    std::mt19937 gen(29);
+    auto random_limb = [&]() {
+        limb_t limb = 0;
+        for (int i = 0; i < BASE_POW / 32; ++i) {
+            limb = (limb << 16 << 16) | gen();
+        }
+        return limb;
+    };
+    for (size_t n = 1; n <= 13; ++n) {
+        const BigInteger span_base = BigInteger(1) << (int) (BASE_POW * n);
+        for (int all_ones = 0; all_ones < 2; ++all_ones) {
+            limb_t a[13], b[13], r[13];
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = all_ones ? ~(limb_t) 0 : random_limb();
+                b[i] = all_ones ? ~(limb_t) 0 : random_limb();
+            }
+            const limb_t d = all_ones ? ~(limb_t) 0 : random_limb();
+
+            limb_t high = add_n(r, a, b, n);
+            EXPECT_EQ(value(a, n) + value(b, n), value(r, n) + span_base * BigInteger(high));
+
+            copy_limbs(r, b, n);
+            high = addmul_1(r, a, n, d);
+            EXPECT_EQ(value(b, n) + value(a, n) * BigInteger(d), value(r, n) + span_base * BigInteger(high));
+
+            copy_limbs(r, a, n);
+            EXPECT_EQ(add_n(a, a, b, n), add_n(r, r, b, n));
+            EXPECT_EQ(0, cmp(a, r, n));
+        }
+    }
+}
+
+#ifdef BIGINTEGER_X86_KERNELS
+TEST(correctness, x86_limb_kernels)
+{
+    // The dispatch picks the kernels only on CPUs with BMI2 and ADX, they are checked against plain loops here
+    if (!cpu_has_bmi2_adx()) {
+        return;
+    }
+    std::mt19937_64 gen(30);
+    for (size_t n = x86_block; n <= 4 * x86_block; n += x86_block) {
+        for (int all_ones = 0; all_ones < 2; ++all_ones) {
+            limb_t a[4 * x86_block], b[4 * x86_block], r[4 * x86_block], expected[4 * x86_block];
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = all_ones ? ~(limb_t) 0 : gen();
+                b[i] = all_ones ? ~(limb_t) 0 : gen();
+            }
+            const limb_t d = all_ones ? ~(limb_t) 0 : gen();
+
+            double_limb_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += (double_limb_t) a[i] + b[i];
+                expected[i] = (limb_t) carry;
+                carry >>= BASE_POW;
+            }
+            EXPECT_EQ((limb_t) carry, add_n_x86(r, a, b, n));
+            EXPECT_EQ(0, cmp(expected, r, n));
+
+            carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += (double_limb_t) a[i] * d + b[i];
+                expected[i] = (limb_t) carry;
+                carry >>= BASE_POW;
+            }
+            copy_limbs(r, b, n);
+            EXPECT_EQ((limb_t) carry, addmul_1_x86(r, a, n, d));
+            EXPECT_EQ(0, cmp(expected, r, n));
+        }
+    }
+}
+#endif
+
+TEST(correctness, bitwise_native_values)
+{
+    std::mt19937 gen(30);
+    for (int i = 0; i < 2000; ++i) {
+        long long a = (long long) (((uint64_t) gen() << 32) | gen()) >> (gen() % 64);
+        long long b = (long long) (((uint64_t) gen() << 32) | gen()) >> (gen() % 64);
+        EXPECT_EQ(BigInteger(a & b), BigInteger(a) & BigInteger(b));
+        EXPECT_EQ(BigInteger(a | b), BigInteger(a) | BigInteger(b));
+        EXPECT_EQ(BigInteger(a ^ b), BigInteger(a) ^ BigInteger(b));
+        EXPECT_EQ(BigInteger(~a), ~BigInteger(a));
+    }
+    // The two's complement of both operands is zero in the low limb, the result needs a limb more
+    const BigInteger limb_base = BigInteger(1) << BASE_POW;
+    EXPECT_EQ(-limb_base, BigInteger(-2) & -(limb_base - 1));
+    EXPECT_EQ(-limb_base * limb_base, (-limb_base * limb_base) | (limb_base * limb_base * 5));
+}
+
+TEST(correctness, bitwise_long_operands)
+{
+    std::mt19937 gen(31);
+    for (size_t an : {1, 3, 15, 16, 17, 40}) {
+        for (size_t bn : {1, 2, 16, 33}) {
+            for (int signs = 0; signs < 4; ++signs) {
+                // Low zero limbs make the two's complement carries run further
+                BigInteger a = random_big_integer(an, gen) << (BASE_POW * (int) (gen() % 3));
+                BigInteger b = random_big_integer(bn, gen) << (BASE_POW * (int) (gen() % 3));
+                if (signs & 1) a = -a;
+                if (signs & 2) b = -b;
+
+                const BigInteger a_and_b = a & b, a_or_b = a | b, a_xor_b = a ^ b;
+                EXPECT_EQ(a_and_b, b & a);
+                EXPECT_EQ(a + b, a_xor_b + a_and_b * 2);
+                EXPECT_EQ(a + b, a_or_b + a_and_b);
+                EXPECT_EQ(~a_and_b, ~a | ~b);
+                EXPECT_EQ(a, a_xor_b ^ b);
+                EXPECT_EQ(a, a & a);
+                EXPECT_EQ(a, a | a);
+                EXPECT_EQ(0, a ^ a);
+            }
+        }
+    }
+    // The high limbs of the longer operand must not leak into the result
+    const BigInteger high = (BigInteger(1) << 200) + 5;
+    EXPECT_EQ(1, high & 3);
+    EXPECT_EQ(1, 3 & high);
+    EXPECT_EQ(high - 1, high & -4);
+}
+
+#ifdef BIGINTEGER_X86_SIMD
+TEST(correctness, x86_vector_kernels)
+{
+    // The dispatch picks only the widest vectors of the CPU, so each supported width is checked here
+    std::mt19937 gen(31);
+    const size_t bytes = cpu_vector_bytes();
+    for (size_t width : {32, 64}) {
+        if (bytes < width) {
+            continue;
+        }
+        const size_t n = 3 * width / sizeof(limb_t);
+        limb_t a[3 * 64 / sizeof(limb_t)], b[3 * 64 / sizeof(limb_t)], r[3 * 64 / sizeof(limb_t)];
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = (limb_t) (((uint64_t) gen() << 32) | gen());
+            b[i] = (limb_t) (((uint64_t) gen() << 32) | gen());
+        }
+        for (limb_t ma : {(limb_t) 0, ~(limb_t) 0}) {
+            for (limb_t mb : {(limb_t) 0, ~(limb_t) 0}) {
+                const limb_t mr = ma & mb;
+                (width == 64 ? and_n_avx512 : and_n_avx2)(r, a, b, n, ma, mb, mr);
+                for (size_t i = 0; i < n; ++i) {
+                    EXPECT_EQ(((a[i] ^ ma) & (b[i] ^ mb)) ^ mr, r[i]);
+                }
+            }
+            (width == 64 ? xor_n_avx512 : xor_n_avx2)(r, a, b, n, ma);
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_EQ(a[i] ^ b[i] ^ ma, r[i]);
+            }
+        }
+    }
+}
+#endif
+
+TEST(correctness, shift_native_count)
+{
+    std::mt19937 gen(32);
+    for (int sign : {1, -1}) {
+        const BigInteger a = random_big_integer(5, gen) * sign;
+        for (unsigned s : {0u, 1u, 31u, 32u, 33u, 63u, 64u, 65u, 200u, 1000u}) {
+            const BigInteger p = pow(BigInteger(2), s);
+            EXPECT_EQ(a * p, a << s);
+            EXPECT_EQ(a << BigInteger(s), a << s);
+            // Rounds towards minus infinity
+            BigInteger q = a / p;
+            if (q * p != a && a < 0) {
+                --q;
+            }
+            EXPECT_EQ(q, a >> s);
+            EXPECT_EQ(a >> BigInteger(s), a >> s);
+        }
+    }
+    const BigInteger two_64 = BigInteger(1) << 64;
+    EXPECT_EQ(-1, BigInteger(-1) >> 1000);
+    EXPECT_EQ(0, BigInteger(5) >> 1000);
+    EXPECT_EQ(-1, -two_64 >> 64);
+    EXPECT_EQ(-2, (-two_64 - 1) >> 64);
+    EXPECT_EQ(0, BigInteger(0) << 100);
+
+    BigInteger a = 5;
+    EXPECT_THROW(a << -1, std::invalid_argument);
+    EXPECT_THROW(a >>= -1, std::invalid_argument);
+    EXPECT_THROW(a >>= BigInteger(-1), std::invalid_argument);
+    EXPECT_EQ(5, a);
+}
+
+TEST(correctness, shift_in_place)
+{
+    BigInteger a = pow(BigInteger(3), 500);
+    BigInteger c = a << 300;
+    c >>= 300;
+    const size_t allocations = heap_allocations;
+    for (int i = 0; i < 3; ++i) {
+        c <<= 300;
+        c >>= 299;
+        c >>= 1;
+    }
+    EXPECT_EQ(allocations, heap_allocations);
+    EXPECT_EQ(a, c);
+}
+
+TEST(correctness, bit_queries_native_values)
+{
+    std::mt19937 gen(33);
+    for (int i = 0; i < 2000; ++i) {
+        const long long a = (long long) (((uint64_t) gen() << 32) | gen()) >> (gen() % 64);
+        const uint64_t bits = a < 0 ? ~(uint64_t) a : (uint64_t) a;
+        const BigInteger big = a;
+        EXPECT_EQ((size_t) std::bit_width(bits), big.bit_length());
+        EXPECT_EQ((size_t) std::popcount(bits), big.popcount());
+        EXPECT_EQ(a == 0 ? 0u : (size_t) std::countr_zero((uint64_t) a), big.count_trailing_zeros());
+        for (size_t n : {0u, 1u, 5u, 31u, 32u, 62u, 63u, 64u, 100u}) {
+            const bool bit = n < 64 ? (a >> n) & 1 : a < 0;
+            EXPECT_EQ(bit, big.test_bit(n));
+            if (n < 63) {
+                const long long mask = 1ll << n;
+                EXPECT_EQ(BigInteger(a | mask), BigInteger(a).set_bit(n));
+                EXPECT_EQ(BigInteger(a & ~mask), BigInteger(a).clear_bit(n));
+                EXPECT_EQ(BigInteger(a ^ mask), BigInteger(a).flip_bit(n));
+            }
+        }
+    }
+    EXPECT_EQ(0u, BigInteger(-1).bit_length());
+    EXPECT_EQ(3u, BigInteger(-8).bit_length());
+    EXPECT_EQ(4u, BigInteger(-9).bit_length());
+    EXPECT_EQ(0u, BigInteger(0).count_trailing_zeros());
+}
+
+TEST(correctness, bit_queries_long_values)
+{
+    std::mt19937 gen(34);
+    for (int sign : {1, -1}) {
+        for (size_t shift : {0u, 31u, 64u, 129u}) {
+            const BigInteger a = (random_big_integer(4, gen) << shift) * sign;
+            const BigInteger form = a < 0 ? ~a : a;
+            EXPECT_EQ(form.bit_length(), a.bit_length());
+            EXPECT_EQ(form.popcount(), a.popcount());
+            EXPECT_EQ(a.count_trailing_zeros(), (-a).count_trailing_zeros());
+            EXPECT_EQ(a, (a >> a.count_trailing_zeros()) << a.count_trailing_zeros());
+            for (size_t n = 0; n < 300; n += 7) {
+                const BigInteger bit = BigInteger(1) << n;
+                EXPECT_EQ(((a >> n) & 1) == 1, a.test_bit(n));
+                EXPECT_EQ(a | bit, BigInteger(a).set_bit(n));
+                EXPECT_EQ(a & ~bit, BigInteger(a).clear_bit(n));
+                EXPECT_EQ(a ^ bit, BigInteger(a).flip_bit(n));
+            }
+        }
+    }
+    const BigInteger two_256 = BigInteger(1) << 256;
+    EXPECT_EQ(256u, (-two_256).bit_length());
+    EXPECT_EQ(257u, (-two_256 - 1).bit_length());
+    EXPECT_EQ(257u, two_256.bit_length());
+    EXPECT_EQ(1u, two_256.popcount());
+    EXPECT_EQ(256u, (-two_256).popcount());
+    EXPECT_EQ(-two_256 + 1, BigInteger(-two_256).set_bit(0));
+    EXPECT_EQ(1, BigInteger(two_256).flip_bit(256).flip_bit(0));
+}
+
+#ifdef BIGINTEGER_X86_SIMD
+TEST(correctness, x86_popcount)
+{
+    if (!cpu_has_popcnt()) {
+        return;
+    }
+    std::mt19937 gen(32);
+    limb_t a[17];
+    size_t expected = 0;
+    for (limb_t &limb : a) {
+        limb = (limb_t) (((uint64_t) gen() << 32) | gen());
+        expected += std::popcount(limb);
+    }
+    EXPECT_EQ(expected, popcount_n_x86(a, 17));
+    EXPECT_EQ(0u, popcount_n_x86(a, 0));
+}
+#endif
+
+TEST(correctness, power_of_two_radix_strings)
+{
+    EXPECT_EQ(255, BigInteger::from_string("ff", 16));
+    EXPECT_EQ(255, BigInteger::from_string("FF", 16));
+    EXPECT_EQ(-5, BigInteger::from_string("-101", 2));
+    EXPECT_EQ(64, BigInteger::from_string("BA", 64));
+    EXPECT_EQ(0, BigInteger::from_string("-0000", 8));
+    EXPECT_EQ(BigInteger("123456789"), BigInteger::from_string("123456789", 10));
+    EXPECT_EQ("ff", to_string(BigInteger(255), 16));
+    EXPECT_EQ("-101", to_string(BigInteger(-5), 2));
+    EXPECT_EQ("BA", to_string(BigInteger(64), 64));
+    EXPECT_EQ("0", to_string(BigInteger(0), 32));
+    EXPECT_EQ("-123", to_string(BigInteger(-123), 10));
+
+    std::mt19937 gen(35);
+    for (int radix : {2, 4, 8, 16, 32, 64}) {
+        for (size_t limbs : {1, 2, 7}) {
+            const BigInteger a = random_big_integer(limbs, gen) * (limbs == 2 ? -1 : 1);
+            const std::string s = to_string(a, radix);
+            EXPECT_EQ(a, BigInteger::from_string(s, radix));
+            // The highest digit is the value of the number shifted by all other digits
+            const int bits = std::countr_zero((unsigned) radix);
+            const size_t sign = a < 0 ? 1 : 0;
+            const BigInteger high = abs(a) >> (bits * (s.size() - sign - 1));
+            EXPECT_EQ(high, digit_value(s[sign], radix));
+        }
+    }
+    EXPECT_THROW(BigInteger::from_string("12", 48), std::invalid_argument);
+    EXPECT_THROW(BigInteger::from_string("102", 2), std::invalid_argument);
+    EXPECT_THROW(BigInteger::from_string("g", 16), std::invalid_argument);
+    EXPECT_THROW(BigInteger::from_string("-", 16), std::invalid_argument);
+    EXPECT_THROW(to_string(BigInteger(5), 128), std::invalid_argument);
+}
+
+TEST(correctness, import_export_bytes)
+{
+    const uint8_t bytes[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    BigInteger a;
+    a.import_bytes(bytes, 3);
+    EXPECT_EQ(0x030201, a);
+    a.import_bytes(bytes, 3, std::endian::big);
+    EXPECT_EQ(0x010203, a);
+    a.import_bytes(bytes, 9, std::endian::big);
+    EXPECT_EQ(BigInteger::from_string("010203040506070809", 16), a);
+    a.import_bytes(bytes, 0);
+    EXPECT_EQ(0, a);
+    EXPECT_EQ(0u, a.byte_count());
+    // Empty buffers may be null
+    a.import_bytes(nullptr, 0);
+    EXPECT_EQ(0, a);
+    EXPECT_EQ(0u, a.export_bytes(nullptr));
+
+    std::mt19937 gen(36);
+    for (std::endian order : {std::endian::little, std::endian::big}) {
+        for (size_t limbs : {1, 3, 8}) {
+            const BigInteger b = random_big_integer(limbs, gen) >> (gen() % 32);
+            std::vector<uint8_t> out(b.byte_count());
+            EXPECT_EQ(out.size(), b.export_bytes(out.data(), order));
+            EXPECT_NE(0, order == std::endian::little ? out.back() : out.front());
+            EXPECT_EQ(b, a.import_bytes(out.data(), out.size(), order));
+            // Only the absolute value is exported
+            std::vector<uint8_t> negative_out(out.size());
+            (-b).export_bytes(negative_out.data(), order);
+            EXPECT_EQ(out, negative_out);
+        }
+    }
+}
+
+TEST(correctness, arbitrary_radix_strings)
+{
+    EXPECT_EQ("zz", to_string(BigInteger(35 * 36 + 35), 36));
+    EXPECT_EQ(-(35 * 36 + 35), BigInteger::from_string("-ZZ", 36));
+    EXPECT_EQ("-1201", to_string(BigInteger(-46), 3));
+    EXPECT_EQ(BigInteger("98765432109876543210"), BigInteger::from_string("98765432109876543210", 10));
+    EXPECT_THROW(BigInteger::from_string("19", 9), std::invalid_argument);
+    EXPECT_THROW(BigInteger::from_string("1", 37), std::invalid_argument);
+    EXPECT_THROW(to_string(BigInteger(1), 1), std::invalid_argument);
+
+    std::mt19937 gen(37);
+    for (int radix : {3, 7, 10, 12, 36}) {
+        // Long numbers are converted by divide and conquer with the cached powers
+        for (size_t limbs : {1, 5, 100}) {
+            const BigInteger a = random_big_integer(limbs, gen) * (limbs == 5 ? -1 : 1);
+            const std::string s = to_string(a, radix);
+            EXPECT_EQ(a, BigInteger::from_string(s, radix));
+
+            // Digits peeled off by short divisions
+            std::string expected;
+            BigInteger rest = abs(a);
+            while (rest != 0) {
+                expected += digit_char(std::stoi(to_string(rest % radix)), radix);
+                rest /= radix;
+            }
+            if (a < 0) {
+                expected += '-';
+            }
+            std::reverse(expected.begin(), expected.end());
+            EXPECT_EQ(expected, s);
+        }
+    }
+
+    // The powers cached for a radix outlive the allocator that is current when they are built
+    const BigInteger a = random_big_integer(1000, gen);
+    for (int radix : {5, 11, 29}) {
+        std::string s;
+        Arena arena;
+        {
+            AllocatorScope scope(arena);
+            s = to_string(a, radix);
+            EXPECT_EQ(a, BigInteger::from_string(s, radix));
+        }
+        arena.reset();
+        {
+            AllocatorScope scope(arena);
+            EXPECT_EQ(a * a, BigInteger(a).square());
+        }
+        EXPECT_EQ(s, to_string(a, radix));
+        EXPECT_EQ(a, BigInteger::from_string(s, radix));
+    }
+}
+
+TEST(correctness, to_chars_and_from_chars)
+{
+    char buffer[64];
+    const BigInteger a("-123456789012345678901234567890");
+    auto [end, ec] = to_chars(buffer, buffer + sizeof(buffer), a);
+    EXPECT_EQ(std::errc(), ec);
+    EXPECT_EQ("-123456789012345678901234567890", std::string(buffer, end));
+    EXPECT_LE((size_t) (end - buffer), to_chars_max_size(a));
+
+    // Fits exactly although the bound is larger
+    const size_t size = end - buffer;
+    EXPECT_EQ(buffer + size, to_chars(buffer, buffer + size, a).ptr);
+    EXPECT_EQ(std::errc::value_too_large, to_chars(buffer, buffer + size - 1, a).ec);
+    EXPECT_EQ(std::errc::value_too_large, to_chars(buffer, buffer + 1, a).ec);
+
+    // Long numbers are written by divide and conquer, a buffer that is too short is rejected without allocations
+    for (const BigInteger &b : {pow(BigInteger(10), 1000), pow(BigInteger(10), 1000) - 1, -pow(BigInteger(7), 2000)}) {
+        const std::string expected = to_string(b);
+        std::string chars(expected.size(), ' ');
+        EXPECT_EQ(chars.data() + chars.size(), to_chars(chars.data(), chars.data() + chars.size(), b).ptr);
+        EXPECT_EQ(expected, chars);
+        EXPECT_EQ(std::errc::value_too_large, to_chars(chars.data(), chars.data() + chars.size() - 1, b).ec);
+        const size_t allocations = heap_allocations;
+        EXPECT_EQ(std::errc::value_too_large, to_chars(chars.data(), chars.data() + chars.size() / 2, b).ec);
+        EXPECT_EQ(allocations, heap_allocations);
+    }
+
+    end = to_chars(buffer, buffer + sizeof(buffer), BigInteger(-255), 16).ptr;
+    EXPECT_EQ("-ff", std::string(buffer, end));
+    end = to_chars(buffer, buffer + sizeof(buffer), BigInteger(0), 7).ptr;
+    EXPECT_EQ("0", std::string(buffer, end));
+
+    BigInteger value = 42;
+    const std::string s = "-123abc";
+    auto [ptr, parse_ec] = from_chars(s.data(), s.data() + s.size(), value);
+    EXPECT_EQ(std::errc(), parse_ec);
+    EXPECT_EQ(s.data() + 4, ptr);
+    EXPECT_EQ(-123, value);
+    EXPECT_EQ(s.data() + s.size(), from_chars(s.data(), s.data() + s.size(), value, 16).ptr);
+    EXPECT_EQ(BigInteger::from_string("-123abc", 16), value);
+    EXPECT_EQ(std::errc::invalid_argument, from_chars(s.data(), s.data() + 1, value).ec);
+    EXPECT_EQ(std::errc::invalid_argument, from_chars(s.data() + 4, s.data() + s.size(), value).ec);
+    EXPECT_EQ(BigInteger::from_string("-123abc", 16), value);
+
+    std::mt19937 gen(38);
+    for (int base : {2, 10, 16, 36}) {
+        const BigInteger b = -random_big_integer(50, gen);
+        std::string chars(to_chars_max_size(b, base), ' ');
+        end = to_chars(chars.data(), chars.data() + chars.size(), b, base).ptr;
+        EXPECT_EQ(to_string(b, base), std::string(chars.data(), end));
+        BigInteger c;
+        EXPECT_EQ(end, from_chars(chars.data(), end, c, base).ptr);
+        EXPECT_EQ(b, c);
+    }
+}
+
+TEST(correctness, stream_output)
+{
+    std::ostringstream out;
+    out << BigInteger(-42) << ' ' << std::setw(5) << BigInteger(7) << ' ' << pow(BigInteger(10), 300);
+    EXPECT_EQ("-42     7 1" + std::string(300, '0'), out.str());
+}
+
+TEST(correctness, decimal_parser_chunks)
+{
+    std::mt19937 gen(39);
+    DecimalParser parser;
+    // A block has 288 digits with 32-bit limbs and 608 with 64-bit ones
+    for (size_t digits : {1, 287, 288, 289, 607, 608, 609, 5000, 20000}) {
+        std::string s = gen() % 2 ? "-" : "";
+        for (size_t i = 0; i < digits; ++i) {
+            s += (char) ('0' + gen() % 10);
+        }
+        // Random chunks, sometimes empty or split inside a block
+        for (size_t begin = 0; begin < s.size();) {
+            const size_t size = min<size_t>(gen() % 700, s.size() - begin);
+            parser.feed(std::span<const char>(s.data() + begin, size));
+            begin += size;
+        }
+        EXPECT_EQ(BigInteger(s), parser.finish());
+    }
+
+    // The parser is reset by finish()
+    parser.feed(std::string_view("-"));
+    parser.feed(std::string_view("000"));
+    const BigInteger zero = parser.finish();
+    EXPECT_EQ(0, zero);
+    EXPECT_EQ("0", to_string(zero));
+    parser.feed(std::string_view("12"));
+    parser.feed(std::string_view("34"));
+    EXPECT_EQ(1234, parser.finish());
+
+    EXPECT_THROW(parser.finish(), std::invalid_argument);
+    parser.feed(std::string_view("-"));
+    EXPECT_THROW(parser.finish(), std::invalid_argument);
+    // A bad char is reported by the feed that gets it, even inside a partial block
+    EXPECT_THROW(parser.feed(std::string_view("12a")), std::invalid_argument);
+    EXPECT_THROW(parser.finish(), std::invalid_argument);
+    parser.feed(std::string_view("12"));
+    EXPECT_THROW(parser.feed(std::string_view("3-")), std::invalid_argument);
+    EXPECT_THROW(parser.feed(std::string(5000, 'x')), std::invalid_argument);
+    parser.feed(std::string_view("-5"));
+    EXPECT_EQ(-5, parser.finish());
+}